@@ -0,0 +1,338 @@
+#include "Engine.h"
+#include "VulkanUtils.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	struct LightingUniforms
+	{
+		glm::mat4 view;
+		glm::mat4 viewProjection;
+		glm::mat4 inverseProjection;
+		glm::vec4 depthSlicing;
+		glm::vec4 screenSize;
+		uint32_t lightCount;
+	};
+
+	struct LightingCounters
+	{
+		uint32_t binnedLights;
+		uint32_t maxClusterLights;
+		uint32_t overflowedClusters;
+	};
+
+	const uint32_t CLUSTER_GRID_X = 16;
+	const uint32_t CLUSTER_GRID_Y = 9;
+	const uint32_t CLUSTER_GRID_Z = 24;
+	const uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+	const uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+	const uint32_t FLOOR_VERTEX_COUNT = 6;
+	const float LIGHT_ANIMATION_FRAME_TIME = 1.0f / 60.0f;
+}
+
+void Engine::createLightingDescriptorSetLayout()
+{
+	m_vkLightingDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, hostAllocator(MemorySubsystem::Descriptors), {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+		layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+		layoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+	});
+}
+
+void Engine::createLightingResources()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t lightCount = m_settings.lightCount;
+	if (lightCount == 0)
+	{
+		throw std::runtime_error("Clustered lighting needs at least one light.");
+	}
+
+	m_sceneLights = generateSceneLights(lightCount);
+	m_lightingCamera = createLightingCamera(
+		static_cast<float>(m_vkSwapchainExtent.width) / static_cast<float>(m_vkSwapchainExtent.height));
+
+	streamUpload(CommandStreamUpload::SceneLights, m_sceneLights.data(), sizeof(SceneLight) * m_sceneLights.size());
+	streamUpload(CommandStreamUpload::LightingCamera, &m_lightingCamera, sizeof(SceneCamera));
+
+	// The lights move every frame, so each frame in flight gets its own slice
+	// of a persistently mapped buffer to write their positions into.
+	VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+	m_lightSliceSize = (sizeof(SceneLight) * lightCount + alignment - 1) / alignment * alignment;
+
+	VkDeviceSize lightBufferSize = m_lightSliceSize * MAX_FRAMES_IN_FLIGHT;
+	createBuffer(lightBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_vkLightBuffer, m_vkLightBufferMemory, MemorySubsystem::Buffers);
+
+	vkMapMemory(m_vkDevice, m_vkLightBufferMemory, 0, lightBufferSize, 0, &m_lightMapping);
+
+	// Each cluster owns a fixed slice of the index list, so binning needs no
+	// global allocation and shading finds a cluster's lights by its index.
+	createBuffer(sizeof(uint32_t) * CLUSTER_COUNT * (1 + MAX_LIGHTS_PER_CLUSTER), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkClusterBuffer, m_vkClusterBufferMemory, MemorySubsystem::Buffers);
+
+	m_vkLightingUniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	m_vkLightingUniformBufferMemories.resize(MAX_FRAMES_IN_FLIGHT);
+	m_lightingUniformMappings.resize(MAX_FRAMES_IN_FLIGHT);
+	m_vkLightingStatsBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	m_vkLightingStatsBufferMemories.resize(MAX_FRAMES_IN_FLIGHT);
+	m_lightingStatsMappings.resize(MAX_FRAMES_IN_FLIGHT);
+
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		createBuffer(sizeof(LightingUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			m_vkLightingUniformBuffers[i], m_vkLightingUniformBufferMemories[i], MemorySubsystem::Buffers);
+
+		vkMapMemory(m_vkDevice, m_vkLightingUniformBufferMemories[i], 0, sizeof(LightingUniforms), 0,
+			&m_lightingUniformMappings[i]);
+
+		createBuffer(sizeof(LightingCounters),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			m_vkLightingStatsBuffers[i], m_vkLightingStatsBufferMemories[i], MemorySubsystem::Buffers);
+
+		vkMapMemory(m_vkDevice, m_vkLightingStatsBufferMemories[i], 0, sizeof(LightingCounters), 0,
+			&m_lightingStatsMappings[i]);
+		memset(m_lightingStatsMappings[i], 0, sizeof(LightingCounters));
+	}
+
+	createLightingDescriptors();
+
+	m_vkLightingQueryPool = VK_NULL_HANDLE;
+
+	if (properties.limits.timestampComputeAndGraphics)
+	{
+		VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = MAX_FRAMES_IN_FLIGHT * LIGHTING_TIMESTAMP_COUNT;
+
+		VkResult result = vkCreateQueryPool(m_vkDevice, &queryPoolCreateInfo, hostAllocator(MemorySubsystem::Sync), &m_vkLightingQueryPool);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create query pool.");
+		}
+	}
+
+	m_lightingStats = {};
+	m_lightingStats.lightCount = lightCount;
+	m_lightingStats.clusterCount = CLUSTER_COUNT;
+}
+
+void Engine::createLightingDescriptors()
+{
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = MAX_FRAMES_IN_FLIGHT;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = MAX_FRAMES_IN_FLIGHT * 3;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+	poolCreateInfo.poolSizeCount = 2;
+	poolCreateInfo.pPoolSizes = poolSizes;
+
+	VkResult result = vkCreateDescriptorPool(m_vkDevice, &poolCreateInfo, hostAllocator(MemorySubsystem::Descriptors), &m_vkLightingDescriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool.");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts(MAX_FRAMES_IN_FLIGHT, m_vkLightingDescriptorSetLayout);
+	m_vkLightingDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+	VkDescriptorSetAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = m_vkLightingDescriptorPool;
+	allocateInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+	allocateInfo.pSetLayouts = setLayouts.data();
+
+	result = vkAllocateDescriptorSets(m_vkDevice, &allocateInfo, m_vkLightingDescriptorSets.data());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor sets.");
+	}
+
+	std::vector<VkDescriptorBufferInfo> uniformInfos(MAX_FRAMES_IN_FLIGHT);
+	std::vector<VkDescriptorBufferInfo> statsInfos(MAX_FRAMES_IN_FLIGHT);
+	std::vector<VkDescriptorBufferInfo> lightInfos(MAX_FRAMES_IN_FLIGHT);
+	VkDescriptorBufferInfo clusterInfo = { m_vkClusterBuffer, 0, VK_WHOLE_SIZE };
+
+	std::vector<VkWriteDescriptorSet> writes;
+
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		uniformInfos[i] = { m_vkLightingUniformBuffers[i], 0, VK_WHOLE_SIZE };
+		statsInfos[i] = { m_vkLightingStatsBuffers[i], 0, VK_WHOLE_SIZE };
+		lightInfos[i] = { m_vkLightBuffer, m_lightSliceSize * i, sizeof(SceneLight) * m_settings.lightCount };
+
+		VkWriteDescriptorSet uniformWrite = bufferWrite(m_vkLightingDescriptorSets[i], 0, &uniformInfos[i]);
+		uniformWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+		writes.push_back(uniformWrite);
+		writes.push_back(bufferWrite(m_vkLightingDescriptorSets[i], 1, &lightInfos[i]));
+		writes.push_back(bufferWrite(m_vkLightingDescriptorSets[i], 2, &clusterInfo));
+		writes.push_back(bufferWrite(m_vkLightingDescriptorSets[i], 3, &statsInfos[i]));
+	}
+
+	vkUpdateDescriptorSets(m_vkDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void Engine::createLightingPipelines()
+{
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_vkLightingDescriptorSetLayout;
+
+	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkLightBinningPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	m_vkLightBinningPipeline = createComputePipeline("light_binning.spv", m_vkLightBinningPipelineLayout);
+}
+
+void Engine::recordLightBinning(VkCommandBuffer commandBuffer)
+{
+	uint32_t firstQuery = static_cast<uint32_t>(m_currentFrame) * LIGHTING_TIMESTAMP_COUNT;
+	VkExtent2D renderExtent = getRenderExtent();
+
+	// The near and far distances come back out of the projection so slicing
+	// always matches the camera; fragments pick their slice with the same
+	// logarithm the binning pass uses to place slice boundaries.
+	const glm::mat4& projection = m_lightingCamera.projection;
+	float nearDistance = projection[3][2] / projection[2][2];
+	float farDistance = projection[3][2] / (projection[2][2] + 1.0f);
+	float sliceScale = static_cast<float>(CLUSTER_GRID_Z) / std::log(farDistance / nearDistance);
+
+	LightingUniforms uniforms = {};
+	uniforms.view = m_lightingCamera.view;
+	uniforms.viewProjection = m_lightingCamera.viewProjection;
+	uniforms.inverseProjection = glm::inverse(projection);
+	uniforms.depthSlicing = glm::vec4(nearDistance, farDistance, sliceScale, sliceScale * std::log(nearDistance));
+	uniforms.screenSize = glm::vec4(static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.0f, 0.0f);
+	uniforms.lightCount = m_settings.lightCount;
+
+	memcpy(m_lightingUniformMappings[m_currentFrame], &uniforms, sizeof(LightingUniforms));
+
+	// Animation time follows the frame number, so a replay moves the lights
+	// exactly as the captured run did.
+	SceneLight* lights = reinterpret_cast<SceneLight*>(static_cast<uint8_t*>(m_lightMapping) + m_lightSliceSize * m_currentFrame);
+	animateSceneLights(m_sceneLights, static_cast<float>(m_frameNumber) * LIGHT_ANIMATION_FRAME_TIME, lights);
+
+	if (m_vkLightingQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_vkLightingQueryPool, firstQuery, LIGHTING_TIMESTAMP_COUNT);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkLightingQueryPool, firstQuery);
+	}
+
+	vkCmdFillBuffer(commandBuffer, m_vkLightingStatsBuffers[m_currentFrame], 0, VK_WHOLE_SIZE, 0);
+
+	// The cluster lists are shared between frames, so binning also waits for
+	// the previous frame's fragments to stop reading them.
+	memoryBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkLightBinningPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkLightBinningPipelineLayout,
+		0, 1, &m_vkLightingDescriptorSets[m_currentFrame], 0, nullptr);
+	vkCmdDispatch(commandBuffer, CLUSTER_COUNT, 1, 1);
+
+	memoryBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT);
+
+	if (m_vkLightingQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkLightingQueryPool, firstQuery + 1);
+	}
+}
+
+void Engine::recordLitDraw(VkCommandBuffer commandBuffer, VkPipeline pipeline)
+{
+	uint32_t firstQuery = static_cast<uint32_t>(m_currentFrame) * LIGHTING_TIMESTAMP_COUNT;
+
+	if (m_vkLightingQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_vkLightingQueryPool, firstQuery + 2);
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vkPipelineLayout,
+		0, 1, &m_vkLightingDescriptorSets[m_currentFrame], 0, nullptr);
+	vkCmdDraw(commandBuffer, FLOOR_VERTEX_COUNT, 1, 0, 0);
+	++m_pendingFrameStats[m_currentFrame].drawCount;
+
+	if (m_vkLightingQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkLightingQueryPool, firstQuery + 3);
+	}
+}
+
+void Engine::collectLightingStats(uint32_t frameSlot)
+{
+	const LightingCounters* counters = static_cast<const LightingCounters*>(m_lightingStatsMappings[frameSlot]);
+
+	m_lightingStats.averageClusterLights = static_cast<double>(counters->binnedLights) / CLUSTER_COUNT;
+	m_lightingStats.maxClusterLights = counters->maxClusterLights;
+	m_lightingStats.overflowedClusters = counters->overflowedClusters;
+
+	if (m_vkLightingQueryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	uint64_t timestamps[4];
+	VkResult result = vkGetQueryPoolResults(m_vkDevice, m_vkLightingQueryPool,
+		frameSlot * LIGHTING_TIMESTAMP_COUNT, LIGHTING_TIMESTAMP_COUNT,
+		sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	double nanosecondsToMilliseconds = static_cast<double>(m_timestampPeriod) / 1000000.0;
+
+	m_lightingStats.binGpuTimeMs = static_cast<double>(timestamps[1] - timestamps[0]) * nanosecondsToMilliseconds;
+	m_lightingStats.shadeGpuTimeMs = static_cast<double>(timestamps[3] - timestamps[2]) * nanosecondsToMilliseconds;
+}
+
+void Engine::destroyLightingResources()
+{
+	if (m_vkLightingQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(m_vkDevice, m_vkLightingQueryPool, hostAllocator(MemorySubsystem::Sync));
+	}
+
+	vkDestroyPipeline(m_vkDevice, m_vkLightBinningPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkLightBinningPipelineLayout, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyDescriptorPool(m_vkDevice, m_vkLightingDescriptorPool, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkLightingDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		vkDestroyBuffer(m_vkDevice, m_vkLightingStatsBuffers[i], hostAllocator(MemorySubsystem::Buffers));
+		freeDeviceMemory(m_vkLightingStatsBufferMemories[i]);
+		vkDestroyBuffer(m_vkDevice, m_vkLightingUniformBuffers[i], hostAllocator(MemorySubsystem::Buffers));
+		freeDeviceMemory(m_vkLightingUniformBufferMemories[i]);
+	}
+
+	vkDestroyBuffer(m_vkDevice, m_vkClusterBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkClusterBufferMemory);
+	vkDestroyBuffer(m_vkDevice, m_vkLightBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkLightBufferMemory);
+}
@@ -0,0 +1,90 @@
+#include "Engine.h"
+#include <cstring>
+#include <stdexcept>
+
+void Engine::createCommandStream()
+{
+	CommandStreamHeader header;
+	header.width = m_settings.width;
+	header.height = m_settings.height;
+	header.occlusionCulling = m_settings.occlusionCulling;
+	header.sceneInstanceCount = m_settings.sceneInstanceCount;
+	header.sceneFog = m_settings.sceneFog;
+	header.particles = m_settings.particles;
+	header.particleCount = m_settings.particleCount;
+	header.asyncCompute = m_settings.asyncCompute;
+	header.hud = m_settings.hud;
+	header.dynamicResolution = m_settings.dynamicResolution;
+	header.clusteredLighting = m_settings.clusteredLighting;
+	header.lightCount = m_settings.lightCount;
+	header.queuedDraws = m_settings.queuedDraws;
+
+	m_commandStreamWriter.reset(new CommandStreamWriter(m_settings.commandStreamPath, header));
+}
+
+void Engine::recordResource(const CommandStreamResource& resource)
+{
+	std::lock_guard<std::mutex> lock(m_resourceMutex);
+	m_createdResources.push_back(resource);
+
+	if (m_commandStreamWriter)
+	{
+		m_commandStreamWriter->writeResource(resource);
+	}
+}
+
+void Engine::streamUpload(CommandStreamUpload upload, void* data, size_t size)
+{
+	if (m_replaySource != nullptr)
+	{
+		const std::vector<uint8_t>* captured = m_replaySource->findUpload(upload);
+		if (captured == nullptr)
+		{
+			return;
+		}
+
+		if (captured->size() != size)
+		{
+			throw std::runtime_error("Captured upload does not match the replayed scene.");
+		}
+
+		memcpy(data, captured->data(), size);
+	}
+	else if (m_commandStreamWriter)
+	{
+		m_commandStreamWriter->writeUpload(upload, data, size);
+	}
+}
+
+void Engine::compileReplayPipelines()
+{
+	// Every variant the capture drew with is built before the first frame, so
+	// driver compiles never show up in replayed frame times.
+	GraphicsPipelineState state = m_pipelineState;
+
+	for (const CommandStreamFrame& frame : m_replaySource->getFrames())
+	{
+		if (!frame.fallbackPipeline)
+		{
+			state.specializationConstants = frame.specializationConstants;
+			m_pipelineVariants->compile(state);
+		}
+	}
+}
+
+void Engine::setReplaySource(const CommandStreamReader* reader)
+{
+	m_replaySource = reader;
+}
+
+void Engine::replayFrame(const CommandStreamFrame& frame)
+{
+	// Particle seeds and the HUD graph are keyed by frame number, so frames
+	// only reproduce when they are replayed from the start and in order.
+	if (frame.frameNumber != m_frameNumber)
+	{
+		throw std::runtime_error("Replayed frames must start at frame zero and stay in order.");
+	}
+
+	renderFrame(&frame);
+}
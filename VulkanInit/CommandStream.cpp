@@ -0,0 +1,315 @@
+#include "CommandStream.h"
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+	const char MAGIC[4] = { 'V', 'K', 'C', 'S' };
+	const uint32_t VERSION = 4;
+
+	const uint32_t CHUNK_RESOURCE = 1;
+	const uint32_t CHUNK_UPLOAD = 2;
+	const uint32_t CHUNK_FRAME = 3;
+
+	const uint32_t HEADER_OCCLUSION_CULLING = 1 << 0;
+	const uint32_t HEADER_SCENE_FOG = 1 << 1;
+	const uint32_t HEADER_PARTICLES = 1 << 2;
+	const uint32_t HEADER_ASYNC_COMPUTE = 1 << 3;
+	const uint32_t HEADER_HUD = 1 << 4;
+	const uint32_t HEADER_DYNAMIC_RESOLUTION = 1 << 5;
+	const uint32_t HEADER_CLUSTERED_LIGHTING = 1 << 6;
+
+	const uint8_t FRAME_FALLBACK_PIPELINE = 1 << 0;
+	const uint8_t FRAME_HUD_VISIBLE = 1 << 1;
+
+	// Values are stored in host byte order; captures are replayed on the same
+	// little-endian platforms that record them.
+	template <typename T>
+	void append(std::vector<uint8_t>& output, T value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		output.insert(output.end(), bytes, bytes + sizeof(T));
+	}
+
+	class Cursor
+	{
+	private:
+		const uint8_t* m_data;
+		size_t m_size;
+		size_t m_offset;
+
+	public:
+		Cursor(const uint8_t* data, size_t size)
+			: m_data(data),
+			m_size(size),
+			m_offset(0)
+		{
+		}
+
+		size_t remaining() const
+		{
+			return m_size - m_offset;
+		}
+
+		const uint8_t* skip(size_t size)
+		{
+			if (size > remaining())
+			{
+				throw std::runtime_error("Command stream chunk is truncated.");
+			}
+
+			const uint8_t* bytes = m_data + m_offset;
+			m_offset += size;
+			return bytes;
+		}
+
+		template <typename T>
+		T read()
+		{
+			T value;
+			memcpy(&value, skip(sizeof(T)), sizeof(T));
+			return value;
+		}
+	};
+}
+
+CommandStreamWriter::CommandStreamWriter(const std::string& fileName, const CommandStreamHeader& header)
+	: m_file(fileName, std::ios::binary),
+	m_frameCount(0)
+{
+	if (!m_file.is_open())
+	{
+		throw std::runtime_error("Failed to open command stream file.");
+	}
+
+	uint32_t flags = (header.occlusionCulling ? HEADER_OCCLUSION_CULLING : 0) |
+		(header.sceneFog ? HEADER_SCENE_FOG : 0) |
+		(header.particles ? HEADER_PARTICLES : 0) |
+		(header.asyncCompute ? HEADER_ASYNC_COMPUTE : 0) |
+		(header.hud ? HEADER_HUD : 0) |
+		(header.dynamicResolution ? HEADER_DYNAMIC_RESOLUTION : 0) |
+		(header.clusteredLighting ? HEADER_CLUSTERED_LIGHTING : 0);
+
+	std::vector<uint8_t> output(MAGIC, MAGIC + sizeof(MAGIC));
+	append(output, VERSION);
+	append(output, header.width);
+	append(output, header.height);
+	append(output, flags);
+	append(output, header.sceneInstanceCount);
+	append(output, header.particleCount);
+	append(output, header.lightCount);
+	append(output, header.queuedDraws);
+
+	m_file.write(reinterpret_cast<const char*>(output.data()), output.size());
+}
+
+void CommandStreamWriter::writeChunk(uint32_t type, const std::vector<uint8_t>& payload)
+{
+	std::vector<uint8_t> chunkHeader;
+	append(chunkHeader, type);
+	append(chunkHeader, static_cast<uint32_t>(payload.size()));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_file.write(reinterpret_cast<const char*>(chunkHeader.data()), chunkHeader.size());
+	m_file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+
+	if (!m_file.good())
+	{
+		throw std::runtime_error("Failed to write command stream.");
+	}
+}
+
+void CommandStreamWriter::writeResource(const CommandStreamResource& resource)
+{
+	std::vector<uint8_t> payload;
+	append(payload, static_cast<uint32_t>(resource.kind));
+	append(payload, resource.subsystem);
+	append(payload, resource.size);
+	append(payload, resource.width);
+	append(payload, resource.height);
+	append(payload, resource.mipLevels);
+	append(payload, resource.format);
+	append(payload, resource.usage);
+	append(payload, resource.memoryProperties);
+
+	writeChunk(CHUNK_RESOURCE, payload);
+}
+
+void CommandStreamWriter::writeUpload(CommandStreamUpload upload, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	std::vector<uint8_t> payload;
+	payload.reserve(sizeof(uint32_t) + size);
+	append(payload, static_cast<uint32_t>(upload));
+	payload.insert(payload.end(), bytes, bytes + size);
+
+	writeChunk(CHUNK_UPLOAD, payload);
+}
+
+void CommandStreamWriter::writeFrame(const CommandStreamFrame& frame)
+{
+	uint8_t flags = (frame.fallbackPipeline ? FRAME_FALLBACK_PIPELINE : 0) |
+		(frame.hudVisible ? FRAME_HUD_VISIBLE : 0);
+
+	std::vector<uint8_t> payload;
+	append(payload, frame.frameNumber);
+	append(payload, flags);
+	append(payload, frame.renderScale);
+	append(payload, static_cast<uint32_t>(frame.specializationConstants.size()));
+
+	for (uint32_t constant : frame.specializationConstants)
+	{
+		append(payload, constant);
+	}
+
+	append(payload, frame.hud.frameTimeMs);
+	append(payload, frame.hud.cpuTimeMs);
+	append(payload, frame.hud.gpuTimeMs);
+	append(payload, frame.hud.hudCpuTimeMs);
+	append(payload, frame.hud.hudGpuTimeMs);
+	append(payload, frame.hud.drawCount);
+	append(payload, frame.hud.heapUsage);
+	append(payload, frame.hud.heapBudget);
+	append(payload, frame.hud.deviceBytes);
+	append(payload, frame.hud.hostBytes);
+
+	writeChunk(CHUNK_FRAME, payload);
+	++m_frameCount;
+}
+
+uint64_t CommandStreamWriter::getFrameCount() const
+{
+	return m_frameCount;
+}
+
+CommandStreamReader::CommandStreamReader(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open command stream file.");
+	}
+
+	std::vector<uint8_t> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Cursor cursor(contents.data(), contents.size());
+
+	if (cursor.remaining() < sizeof(MAGIC) || memcmp(cursor.skip(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0)
+	{
+		throw std::runtime_error("File is not a command stream.");
+	}
+
+	if (cursor.read<uint32_t>() != VERSION)
+	{
+		throw std::runtime_error("Unsupported command stream version.");
+	}
+
+	m_header.width = cursor.read<uint32_t>();
+	m_header.height = cursor.read<uint32_t>();
+	uint32_t flags = cursor.read<uint32_t>();
+	m_header.sceneInstanceCount = cursor.read<uint32_t>();
+	m_header.particleCount = cursor.read<uint32_t>();
+	m_header.lightCount = cursor.read<uint32_t>();
+	m_header.queuedDraws = cursor.read<uint32_t>();
+	m_header.occlusionCulling = (flags & HEADER_OCCLUSION_CULLING) != 0;
+	m_header.sceneFog = (flags & HEADER_SCENE_FOG) != 0;
+	m_header.particles = (flags & HEADER_PARTICLES) != 0;
+	m_header.asyncCompute = (flags & HEADER_ASYNC_COMPUTE) != 0;
+	m_header.hud = (flags & HEADER_HUD) != 0;
+	m_header.dynamicResolution = (flags & HEADER_DYNAMIC_RESOLUTION) != 0;
+	m_header.clusteredLighting = (flags & HEADER_CLUSTERED_LIGHTING) != 0;
+
+	// A recording cut short by a crash or a killed process ends in a partial
+	// chunk; everything before it is still a valid capture.
+	while (cursor.remaining() >= sizeof(uint32_t) * 2)
+	{
+		uint32_t type = cursor.read<uint32_t>();
+		uint32_t size = cursor.read<uint32_t>();
+
+		if (size > cursor.remaining())
+		{
+			break;
+		}
+
+		Cursor chunk(cursor.skip(size), size);
+
+		if (type == CHUNK_RESOURCE)
+		{
+			CommandStreamResource resource;
+			resource.kind = static_cast<CommandStreamResourceKind>(chunk.read<uint32_t>());
+			resource.subsystem = chunk.read<uint32_t>();
+			resource.size = chunk.read<uint64_t>();
+			resource.width = chunk.read<uint32_t>();
+			resource.height = chunk.read<uint32_t>();
+			resource.mipLevels = chunk.read<uint32_t>();
+			resource.format = chunk.read<uint32_t>();
+			resource.usage = chunk.read<uint32_t>();
+			resource.memoryProperties = chunk.read<uint32_t>();
+
+			m_resources.push_back(resource);
+		}
+		else if (type == CHUNK_UPLOAD)
+		{
+			CommandStreamUpload upload = static_cast<CommandStreamUpload>(chunk.read<uint32_t>());
+			size_t dataSize = chunk.remaining();
+			const uint8_t* data = chunk.skip(dataSize);
+
+			m_uploads[upload].assign(data, data + dataSize);
+		}
+		else if (type == CHUNK_FRAME)
+		{
+			CommandStreamFrame frame;
+			frame.frameNumber = chunk.read<uint64_t>();
+			uint8_t frameFlags = chunk.read<uint8_t>();
+			frame.fallbackPipeline = (frameFlags & FRAME_FALLBACK_PIPELINE) != 0;
+			frame.hudVisible = (frameFlags & FRAME_HUD_VISIBLE) != 0;
+			frame.renderScale = chunk.read<float>();
+			frame.specializationConstants.resize(chunk.read<uint32_t>());
+
+			for (uint32_t& constant : frame.specializationConstants)
+			{
+				constant = chunk.read<uint32_t>();
+			}
+
+			frame.hud.frameTimeMs = chunk.read<double>();
+			frame.hud.cpuTimeMs = chunk.read<double>();
+			frame.hud.gpuTimeMs = chunk.read<double>();
+			frame.hud.hudCpuTimeMs = chunk.read<double>();
+			frame.hud.hudGpuTimeMs = chunk.read<double>();
+			frame.hud.drawCount = chunk.read<uint32_t>();
+			frame.hud.heapUsage = chunk.read<uint64_t>();
+			frame.hud.heapBudget = chunk.read<uint64_t>();
+			frame.hud.deviceBytes = chunk.read<uint64_t>();
+			frame.hud.hostBytes = chunk.read<uint64_t>();
+
+			if (frame.frameNumber != m_frames.size())
+			{
+				throw std::runtime_error("Command stream frames are out of order.");
+			}
+
+			m_frames.push_back(frame);
+		}
+	}
+}
+
+const CommandStreamHeader& CommandStreamReader::getHeader() const
+{
+	return m_header;
+}
+
+const std::vector<CommandStreamResource>& CommandStreamReader::getResources() const
+{
+	return m_resources;
+}
+
+const std::vector<uint8_t>* CommandStreamReader::findUpload(CommandStreamUpload upload) const
+{
+	auto found = m_uploads.find(upload);
+	return found != m_uploads.end() ? &found->second : nullptr;
+}
+
+const std::vector<CommandStreamFrame>& CommandStreamReader::getFrames() const
+{
+	return m_frames;
+}
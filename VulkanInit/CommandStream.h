@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct CommandStreamHeader
+{
+	uint32_t width;
+	uint32_t height;
+	bool occlusionCulling;
+	uint32_t sceneInstanceCount;
+	bool sceneFog;
+	bool particles;
+	uint32_t particleCount;
+	bool asyncCompute;
+	bool hud;
+	bool dynamicResolution;
+	bool clusteredLighting;
+	uint32_t lightCount;
+	uint32_t queuedDraws;
+};
+
+enum class CommandStreamResourceKind : uint32_t
+{
+	Buffer,
+	Image
+};
+
+struct CommandStreamResource
+{
+	CommandStreamResourceKind kind;
+	uint32_t subsystem;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipLevels;
+	uint32_t format;
+	uint32_t usage;
+	uint32_t memoryProperties;
+};
+
+enum class CommandStreamUpload : uint32_t
+{
+	SceneInstances,
+	SceneCamera,
+	ParticleCamera,
+	SceneLights,
+	LightingCamera,
+	QueuedDraws
+};
+
+// The numbers the HUD showed for a frame. They come from timers on the
+// capturing machine, so a replay draws them from the capture instead of
+// measuring its own.
+struct HudReadout
+{
+	double frameTimeMs;
+	double cpuTimeMs;
+	double gpuTimeMs;
+	double hudCpuTimeMs;
+	double hudGpuTimeMs;
+	uint32_t drawCount;
+	uint64_t heapUsage;
+	uint64_t heapBudget;
+	uint64_t deviceBytes;
+	uint64_t hostBytes;
+};
+
+// Everything outside the engine's own state that decides what a frame records.
+struct CommandStreamFrame
+{
+	uint64_t frameNumber;
+	bool fallbackPipeline;
+	bool hudVisible;
+	float renderScale;
+	std::vector<uint32_t> specializationConstants;
+	HudReadout hud;
+};
+
+// Appends a capture to a compact binary file: a header with the settings that
+// define the scene, then tagged chunks for created resources, uploaded data
+// and one record per frame. Init tasks run on worker threads, so writes are
+// serialized.
+class CommandStreamWriter
+{
+private:
+	std::ofstream m_file;
+	std::mutex m_mutex;
+	uint64_t m_frameCount;
+
+	void writeChunk(uint32_t type, const std::vector<uint8_t>& payload);
+
+public:
+	CommandStreamWriter(const std::string& fileName, const CommandStreamHeader& header);
+
+	CommandStreamWriter(const CommandStreamWriter&) = delete;
+	CommandStreamWriter& operator=(const CommandStreamWriter&) = delete;
+
+	void writeResource(const CommandStreamResource& resource);
+	void writeUpload(CommandStreamUpload upload, const void* data, size_t size);
+	void writeFrame(const CommandStreamFrame& frame);
+	uint64_t getFrameCount() const;
+};
+
+// Loads a whole capture up front so a replay never touches the disk between
+// frames.
+class CommandStreamReader
+{
+private:
+	CommandStreamHeader m_header;
+	std::vector<CommandStreamResource> m_resources;
+	std::map<CommandStreamUpload, std::vector<uint8_t>> m_uploads;
+	std::vector<CommandStreamFrame> m_frames;
+
+public:
+	explicit CommandStreamReader(const std::string& fileName);
+
+	CommandStreamReader(const CommandStreamReader&) = delete;
+	CommandStreamReader& operator=(const CommandStreamReader&) = delete;
+
+	const CommandStreamHeader& getHeader() const;
+	const std::vector<CommandStreamResource>& getResources() const;
+	const std::vector<uint8_t>* findUpload(CommandStreamUpload upload) const;
+	const std::vector<CommandStreamFrame>& getFrames() const;
+};
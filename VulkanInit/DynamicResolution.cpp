@@ -0,0 +1,193 @@
+#include "Engine.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+	const double RENDER_SCALE_HEADROOM = 0.9;
+	const float RENDER_SCALE_SMOOTHING = 0.2f;
+	const float RENDER_SCALE_STEP = 0.05f;
+}
+
+void Engine::createScaledRenderPass()
+{
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format = m_vkSwapchainImageFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef = {};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+
+	// One render target is shared by every frame in flight: the pass waits
+	// for the previous frame's upscale to finish reading it, and the upscale
+	// waits for the pass to finish writing it.
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].srcAccessMask = 0;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassCreateInfo.attachmentCount = 1;
+	renderPassCreateInfo.pAttachments = &colorAttachment;
+	renderPassCreateInfo.subpassCount = 1;
+	renderPassCreateInfo.pSubpasses = &subpass;
+	renderPassCreateInfo.dependencyCount = 2;
+	renderPassCreateInfo.pDependencies = dependencies;
+
+	VkResult result = vkCreateRenderPass(m_vkDevice, &renderPassCreateInfo, hostAllocator(MemorySubsystem::RenderTargets), &m_vkScaledRenderPass);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create scaled render pass.");
+	}
+}
+
+void Engine::createScaledRenderTarget()
+{
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_vkPhysicalDevice, m_vkSwapchainImageFormat, &formatProperties);
+
+	VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+	if ((formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures)
+	{
+		throw std::runtime_error("Swap chain format cannot be upscaled with a filtered blit.");
+	}
+
+	// The target is allocated once at full size; lower scales render into
+	// its top left corner, so changing the scale never reallocates.
+	createImage(m_vkSwapchainExtent.width, m_vkSwapchainExtent.height, 1, m_vkSwapchainImageFormat,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		m_vkScaledImage, m_vkScaledImageMemory, MemorySubsystem::RenderTargets);
+
+	m_vkScaledImageView = createImageView(m_vkScaledImage, m_vkSwapchainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1);
+
+	VkFramebufferCreateInfo framebufferCreateInfo = {};
+	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferCreateInfo.renderPass = m_vkScaledRenderPass;
+	framebufferCreateInfo.attachmentCount = 1;
+	framebufferCreateInfo.pAttachments = &m_vkScaledImageView;
+	framebufferCreateInfo.width = m_vkSwapchainExtent.width;
+	framebufferCreateInfo.height = m_vkSwapchainExtent.height;
+	framebufferCreateInfo.layers = 1;
+
+	VkResult result = vkCreateFramebuffer(m_vkDevice, &framebufferCreateInfo, hostAllocator(MemorySubsystem::RenderTargets), &m_vkScaledFramebuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create scaled frame buffer.");
+	}
+}
+
+VkExtent2D Engine::getRenderExtent() const
+{
+	if (!m_settings.dynamicResolution)
+	{
+		return m_vkSwapchainExtent;
+	}
+
+	VkExtent2D extent;
+	extent.width = std::max(1u, static_cast<uint32_t>(std::lround(m_vkSwapchainExtent.width * m_renderScale)));
+	extent.height = std::max(1u, static_cast<uint32_t>(std::lround(m_vkSwapchainExtent.height * m_renderScale)));
+
+	return extent;
+}
+
+void Engine::updateRenderScale()
+{
+	if (m_frameStats.gpuTimeMs <= 0.0)
+	{
+		return;
+	}
+
+	// GPU time is treated as proportional to the rendered pixel count, which
+	// grows with the square of the scale. The measured frame is a few frames
+	// old, so the estimate only moves part of the way towards each answer,
+	// and the applied scale snaps to coarse steps so small jitter in the
+	// timings does not change the resolution every frame.
+	double budgetMs = m_settings.targetFrameTimeMs * RENDER_SCALE_HEADROOM;
+	float desiredScale = m_frameStats.renderScale * static_cast<float>(std::sqrt(budgetMs / m_frameStats.gpuTimeMs));
+
+	m_renderScaleEstimate += (desiredScale - m_renderScaleEstimate) * RENDER_SCALE_SMOOTHING;
+	m_renderScaleEstimate = std::clamp(m_renderScaleEstimate, m_settings.minRenderScale, 1.0f);
+
+	float steppedScale = std::round(m_renderScaleEstimate / RENDER_SCALE_STEP) * RENDER_SCALE_STEP;
+	m_renderScale = std::clamp(steppedScale, m_settings.minRenderScale, 1.0f);
+}
+
+void Engine::recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent)
+{
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = m_vkSwapchainImages[imageIndex];
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkImageBlit region = {};
+	region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.srcSubresource.mipLevel = 0;
+	region.srcSubresource.baseArrayLayer = 0;
+	region.srcSubresource.layerCount = 1;
+	region.srcOffsets[1] = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+	region.dstSubresource = region.srcSubresource;
+	region.dstOffsets[1] = { static_cast<int32_t>(m_vkSwapchainExtent.width), static_cast<int32_t>(m_vkSwapchainExtent.height), 1 };
+
+	vkCmdBlitImage(commandBuffer, m_vkScaledImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		m_vkSwapchainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+
+	// The HUD pass and the frame capture copy both pick the image up in the
+	// layout the main pass would have left it in.
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.newLayout = m_vkPresentLayout;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+}
+
+void Engine::destroyScaledRenderTarget()
+{
+	vkDestroyFramebuffer(m_vkDevice, m_vkScaledFramebuffer, hostAllocator(MemorySubsystem::RenderTargets));
+	vkDestroyImageView(m_vkDevice, m_vkScaledImageView, hostAllocator(MemorySubsystem::RenderTargets));
+	vkDestroyImage(m_vkDevice, m_vkScaledImage, hostAllocator(MemorySubsystem::RenderTargets));
+	freeDeviceMemory(m_vkScaledImageMemory);
+	vkDestroyRenderPass(m_vkDevice, m_vkScaledRenderPass, hostAllocator(MemorySubsystem::RenderTargets));
+}
@@ -5,6 +5,8 @@
 #include <set>
 #include "glm/common.hpp"
 #include <fstream>
+#include <cstring>
+#include <algorithm>
 
 void Engine::initVkInstance()
 {
@@ -16,15 +18,27 @@ void Engine::initVkInstance()
 	vkApplicationInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 	vkApplicationInfo.apiVersion = VK_API_VERSION_1_0;
 
-	unsigned int extensionCount;
-	SDL_Vulkan_GetInstanceExtensions(m_sdlWindow, &extensionCount, nullptr);
-	std::vector<const char*> extensions(extensionCount);
-	SDL_Vulkan_GetInstanceExtensions(m_sdlWindow, &extensionCount, extensions.data());
+	unsigned int extensionCount = 0;
+	std::vector<const char*> extensions;
+
+	if (!m_settings.headless)
+	{
+		SDL_Vulkan_GetInstanceExtensions(m_windows[0].sdlWindow, &extensionCount, nullptr);
+		extensions.resize(extensionCount);
+		SDL_Vulkan_GetInstanceExtensions(m_windows[0].sdlWindow, &extensionCount, extensions.data());
+	}
+
+	if (!checkInstanceExtensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+	{
+		throw std::runtime_error("Physical device properties 2 is not supported.");
+	}
+
+	extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
 	VkInstanceCreateInfo vkInstanceCreateInfo = {};
 	vkInstanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	vkInstanceCreateInfo.pApplicationInfo = &vkApplicationInfo;
-	vkInstanceCreateInfo.enabledExtensionCount = extensionCount;
+	vkInstanceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 	vkInstanceCreateInfo.ppEnabledExtensionNames = extensions.data();
 
 #ifdef _DEBUG
@@ -35,7 +49,7 @@ void Engine::initVkInstance()
 	vkInstanceCreateInfo.ppEnabledLayerNames = validationLayers.data();
 #endif
 
-	VkResult result = vkCreateInstance(&vkInstanceCreateInfo, nullptr, &m_vkInstance);
+	VkResult result = vkCreateInstance(&vkInstanceCreateInfo, hostAllocator(MemorySubsystem::Core), &m_vkInstance);
 
 	if (result != VK_SUCCESS)
 	{
@@ -43,19 +57,27 @@ void Engine::initVkInstance()
 	}
 }
 
-void Engine::createVkSurface()
+void Engine::createVkSurfaces()
 {
-	SDL_bool result = SDL_Vulkan_CreateSurface(m_sdlWindow, m_vkInstance, &m_vkSurface);
-
-	if (result == SDL_FALSE)
+	for (EngineWindow& window : m_windows)
 	{
-		throw std::runtime_error("Failed to create VkSurfaceKHR.");
+		SDL_bool result = SDL_Vulkan_CreateSurface(window.sdlWindow, m_vkInstance, &window.surface);
+
+		if (result == SDL_FALSE)
+		{
+			throw std::runtime_error("Failed to create VkSurfaceKHR.");
+		}
 	}
 }
 
 void Engine::pickPhysicalDevice()
 {
-	m_deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	if (!m_settings.headless)
+	{
+		m_deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
+
+	m_deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
 
 	unsigned int deviceCount = 0;
 	vkEnumeratePhysicalDevices(m_vkInstance, &deviceCount, nullptr);
@@ -68,16 +90,28 @@ void Engine::pickPhysicalDevice()
 	std::vector<VkPhysicalDevice> availableDevices(deviceCount);
 	vkEnumeratePhysicalDevices(m_vkInstance, &deviceCount, availableDevices.data());
 
+	// Any device with the required features will do, so replays also run on
+	// integrated GPUs and software rasterizers; a discrete GPU is preferred.
 	m_vkPhysicalDevice = VK_NULL_HANDLE;
 	for (VkPhysicalDevice availableDevice : availableDevices)
 	{
+		if (!checkDeviceExtensionSupport(availableDevice) ||
+			!checkTimelineSemaphoreSupport(availableDevice) ||
+			!(m_settings.headless || checkSwapchainSupport(availableDevice)) ||
+			!checkQueueFamiliesSupport(availableDevice))
+		{
+			continue;
+		}
+
 		VkPhysicalDeviceProperties properties;
 		vkGetPhysicalDeviceProperties(availableDevice, &properties);
 
-		if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
-			checkDeviceExtensionSupport(availableDevice) &&
-			checkSwapchainSupport(availableDevice) &&
-			checkQueueFamiliesSupport(availableDevice))
+		if (m_vkPhysicalDevice == VK_NULL_HANDLE)
+		{
+			m_vkPhysicalDevice = availableDevice;
+		}
+
+		if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
 		{
 			m_vkPhysicalDevice = availableDevice;
 			break;
@@ -86,42 +120,88 @@ void Engine::pickPhysicalDevice()
 
 	if (m_vkPhysicalDevice == VK_NULL_HANDLE)
 	{
-		throw std::runtime_error("None discrete GPU is available.");
+		throw std::runtime_error("No suitable Vulkan device is available.");
 	}
 }
 
 void Engine::createDevice()
 {
-	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos(2);
-
 	QueueFamilyIndices queueFamilyIndices = findQueueFamilyIndices(m_vkPhysicalDevice);
 	const float queuePriority = 1.0f;
 
-	VkDeviceQueueCreateInfo& graphicsQueueCreateInfo = queueCreateInfos[0];
-	graphicsQueueCreateInfo = {};
-	graphicsQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-	graphicsQueueCreateInfo.queueFamilyIndex = *queueFamilyIndices.graphics;
-	graphicsQueueCreateInfo.queueCount = 1;
-	graphicsQueueCreateInfo.pQueuePriorities = &queuePriority;
+	if (m_settings.particles && m_settings.asyncCompute)
+	{
+		m_computeQueueFamily = findAsyncComputeQueueFamily(m_vkPhysicalDevice);
+	}
+
+	std::vector<uint32_t> queueFamilies = { *queueFamilyIndices.graphics };
+
+	if (queueFamilyIndices.graphics != queueFamilyIndices.presentation)
+	{
+		queueFamilies.push_back(*queueFamilyIndices.presentation);
+	}
+
+	if (m_computeQueueFamily.has_value())
+	{
+		queueFamilies.push_back(*m_computeQueueFamily);
+		m_computeSharingFamilies = { *queueFamilyIndices.graphics, *m_computeQueueFamily };
+	}
+
+	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos(queueFamilies.size());
+
+	for (size_t i = 0; i < queueFamilies.size(); ++i)
+	{
+		queueCreateInfos[i] = {};
+		queueCreateInfos[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfos[i].queueFamilyIndex = queueFamilies[i];
+		queueCreateInfos[i].queueCount = 1;
+		queueCreateInfos[i].pQueuePriorities = &queuePriority;
+	}
 
-	VkDeviceQueueCreateInfo& presentationQueueCreateInfo = queueCreateInfos[1];
-	presentationQueueCreateInfo = {};
-	presentationQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-	presentationQueueCreateInfo.queueFamilyIndex = *queueFamilyIndices.presentation;
-	presentationQueueCreateInfo.queueCount = 1;
-	presentationQueueCreateInfo.pQueuePriorities = &queuePriority;
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_vkPhysicalDevice, &supportedFeatures);
 
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 
+	if (m_settings.occlusionCulling)
+	{
+		if (!supportedFeatures.multiDrawIndirect)
+		{
+			throw std::runtime_error("Multi draw indirect is not supported.");
+		}
+
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+
+		// The culling pass stores each instance's index in its draw command's
+		// firstInstance.
+		if (!supportedFeatures.drawIndirectFirstInstance)
+		{
+			throw std::runtime_error("Draw indirect first instance is not supported.");
+		}
+
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+	}
+
+	m_memoryBudgetSupported = checkMemoryBudgetSupport(m_vkPhysicalDevice);
+	if (m_memoryBudgetSupported)
+	{
+		m_deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+	timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = &timelineSemaphoreFeatures;
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pEnabledFeatures = &deviceFeatures;
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
 	createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
 
-	VkResult result = vkCreateDevice(m_vkPhysicalDevice, &createInfo, nullptr, &m_vkDevice);
+	VkResult result = vkCreateDevice(m_vkPhysicalDevice, &createInfo, hostAllocator(MemorySubsystem::Core), &m_vkDevice);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create device.");
@@ -129,14 +209,70 @@ void Engine::createDevice()
 
 	vkGetDeviceQueue(m_vkDevice, *queueFamilyIndices.graphics, 0, &m_vkGraphicsQueue);
 	vkGetDeviceQueue(m_vkDevice, *queueFamilyIndices.presentation, 0, &m_vkPresentationQueue);
+
+	if (m_computeQueueFamily.has_value())
+	{
+		vkGetDeviceQueue(m_vkDevice, *m_computeQueueFamily, 0, &m_vkComputeQueue);
+	}
+
+	PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+	if (m_memoryBudgetSupported)
+	{
+		getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+			vkGetInstanceProcAddr(m_vkInstance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+	}
+
+	m_memoryTracker->bindPhysicalDevice(m_vkPhysicalDevice, getMemoryProperties2);
 }
 
-void Engine::createSwapChain()
+void Engine::chooseSwapchainFormat()
 {
-	SwapChainSupportDetails supportDetails = querySwapChainSupport(m_vkPhysicalDevice);
+	if (m_settings.headless)
+	{
+		m_vkSwapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		m_vkSwapchainColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+		m_vkSwapchainExtent.width = m_settings.width;
+		m_vkSwapchainExtent.height = m_settings.height;
+		return;
+	}
+
+	SwapChainSupportDetails supportDetails = querySwapChainSupport(m_vkPhysicalDevice, m_windows[0].surface);
 	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(supportDetails.formats);
+
+	m_vkSwapchainImageFormat = surfaceFormat.format;
+	m_vkSwapchainColorSpace = surfaceFormat.colorSpace;
+
+	// Every window is drawn with the same render pass and pipelines, so the
+	// other windows have to support the first window's format.
+	for (EngineWindow& window : m_windows)
+	{
+		if (&window != &m_windows[0])
+		{
+			supportDetails = querySwapChainSupport(m_vkPhysicalDevice, window.surface);
+		}
+
+		bool formatSupported = false;
+		for (const VkSurfaceFormatKHR& format : supportDetails.formats)
+		{
+			formatSupported = formatSupported ||
+				(format.format == m_vkSwapchainImageFormat && format.colorSpace == m_vkSwapchainColorSpace);
+		}
+
+		if (!formatSupported)
+		{
+			throw std::runtime_error("Window does not support the swap chain format.");
+		}
+
+		window.extent = chooseSwapExtent(supportDetails.capabilities, window.sdlWindow);
+	}
+
+	m_vkSwapchainExtent = m_windows[0].extent;
+}
+
+void Engine::createSwapChain(EngineWindow& window)
+{
+	SwapChainSupportDetails supportDetails = querySwapChainSupport(m_vkPhysicalDevice, window.surface);
 	VkPresentModeKHR presentMode = chooseSwapPresentMode(supportDetails.presentModes);
-	VkExtent2D extent = chooseSwapExtent(supportDetails.capabilities);
 
 	uint32_t imageCount = supportDetails.capabilities.minImageCount + 1;
 	
@@ -148,14 +284,34 @@ void Engine::createSwapChain()
 
 	VkSwapchainCreateInfoKHR swapChainCreateInfo = {};
 	swapChainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	swapChainCreateInfo.surface = m_vkSurface;
+	swapChainCreateInfo.surface = window.surface;
 	swapChainCreateInfo.minImageCount = imageCount;
-	swapChainCreateInfo.imageFormat = surfaceFormat.format;
-	swapChainCreateInfo.imageColorSpace = surfaceFormat.colorSpace;
-	swapChainCreateInfo.imageExtent = extent;
+	swapChainCreateInfo.imageFormat = m_vkSwapchainImageFormat;
+	swapChainCreateInfo.imageColorSpace = m_vkSwapchainColorSpace;
+	swapChainCreateInfo.imageExtent = window.extent;
 	swapChainCreateInfo.imageArrayLayers = 1;
 	swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+	if (m_settings.captureFormat != CaptureFormat::None)
+	{
+		if (!(supportDetails.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+		{
+			throw std::runtime_error("Swap chain images cannot be captured.");
+		}
+
+		swapChainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+
+	if (m_settings.dynamicResolution)
+	{
+		if (!(supportDetails.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+		{
+			throw std::runtime_error("Swap chain images cannot be upscaled into.");
+		}
+
+		swapChainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	}
+
 	QueueFamilyIndices queueFamilyIndices = findQueueFamilyIndices(m_vkPhysicalDevice);
 	std::vector<uint32_t> indices;
 	indices.push_back(queueFamilyIndices.graphics.value());
@@ -176,27 +332,50 @@ void Engine::createSwapChain()
 	swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	swapChainCreateInfo.presentMode = presentMode;
 	swapChainCreateInfo.clipped = VK_TRUE;
-	swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+	swapChainCreateInfo.oldSwapchain = window.swapchain;
 
-	VkResult result = vkCreateSwapchainKHR(m_vkDevice, &swapChainCreateInfo, nullptr, &m_vkSwapchain);
+	VkSwapchainKHR swapchain;
+	VkResult result = vkCreateSwapchainKHR(m_vkDevice, &swapChainCreateInfo, hostAllocator(MemorySubsystem::Swapchain), &swapchain);
 
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create swap chain.");
 	}
 
+	if (window.swapchain != VK_NULL_HANDLE)
+	{
+		vkDestroySwapchainKHR(m_vkDevice, window.swapchain, hostAllocator(MemorySubsystem::Swapchain));
+	}
+
+	window.swapchain = swapchain;
+
 	uint32_t finalImageCount;
-	vkGetSwapchainImagesKHR(m_vkDevice, m_vkSwapchain, &finalImageCount, nullptr);
-	m_vkSwapchainImages.resize(finalImageCount);
-	vkGetSwapchainImagesKHR(m_vkDevice, m_vkSwapchain, &finalImageCount, m_vkSwapchainImages.data());
+	vkGetSwapchainImagesKHR(m_vkDevice, window.swapchain, &finalImageCount, nullptr);
+	window.images.resize(finalImageCount);
+	vkGetSwapchainImagesKHR(m_vkDevice, window.swapchain, &finalImageCount, window.images.data());
+}
 
-	m_vkSwapchainImageFormat = surfaceFormat.format;
-	m_vkSwapchainExtent = extent;
+void Engine::createOffscreenImages()
+{
+	m_vkSwapchainImages.resize(MAX_FRAMES_IN_FLIGHT);
+	m_vkOffscreenImageMemories.resize(MAX_FRAMES_IN_FLIGHT);
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	if (m_settings.dynamicResolution)
+	{
+		usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	}
+
+	for (size_t i = 0; i < m_vkSwapchainImages.size(); ++i)
+	{
+		createImage(m_vkSwapchainExtent.width, m_vkSwapchainExtent.height, 1, m_vkSwapchainImageFormat, usage,
+			m_vkSwapchainImages[i], m_vkOffscreenImageMemories[i], MemorySubsystem::Swapchain);
+	}
 }
 
-void Engine::createSwapChainImageViews()
+void Engine::createSwapChainImageViews(const std::vector<VkImage>& images, std::vector<VkImageView>& imageViews)
 {
-	m_vkSwapchainImageViews.resize(m_vkSwapchainImages.size());
+	imageViews.resize(images.size());
 
 	VkImageViewCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -212,11 +391,11 @@ void Engine::createSwapChainImageViews()
 	createInfo.subresourceRange.baseArrayLayer = 0;
 	createInfo.subresourceRange.layerCount = 1;
 
-	for (size_t i = 0; i < m_vkSwapchainImageViews.size(); ++i)
+	for (size_t i = 0; i < imageViews.size(); ++i)
 	{
-		createInfo.image = m_vkSwapchainImages[i];
+		createInfo.image = images[i];
 
-		VkResult result = vkCreateImageView(m_vkDevice, &createInfo, nullptr, &m_vkSwapchainImageViews[i]);
+		VkResult result = vkCreateImageView(m_vkDevice, &createInfo, hostAllocator(MemorySubsystem::Swapchain), &imageViews[i]);
 		if (result != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create swap chain image view.");
@@ -234,7 +413,7 @@ void Engine::createRenderPass()
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout = m_vkPresentLayout;
 
 	VkAttachmentReference colorAttachmentRef = {};
 	colorAttachmentRef.attachment = 0;
@@ -262,38 +441,214 @@ void Engine::createRenderPass()
 	renderPassCreateInfo.dependencyCount = 1;
 	renderPassCreateInfo.pDependencies = &dependency;
 
-	VkResult result = vkCreateRenderPass(m_vkDevice, &renderPassCreateInfo, nullptr, &m_vkRenderPass);
+	VkResult result = vkCreateRenderPass(m_vkDevice, &renderPassCreateInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkRenderPass);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create render pass.");
 	}
 }
 
+void Engine::choosePipelineState()
+{
+	if (m_settings.occlusionCulling)
+	{
+		m_pipelineState.vertexShader = "scene_vertex.spv";
+		m_pipelineState.fragmentShader = "scene_fragment.spv";
+		m_pipelineState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		m_pipelineState.depthTest = true;
+		m_pipelineState.specializationConstants = { VK_FALSE };
+	}
+	else if (m_settings.particles)
+	{
+		m_pipelineState.vertexShader = "particle_vertex.spv";
+		m_pipelineState.fragmentShader = "particle_fragment.spv";
+		m_pipelineState.cullMode = VK_CULL_MODE_NONE;
+		m_pipelineState.blendEnable = true;
+	}
+	else if (m_settings.clusteredLighting)
+	{
+		m_pipelineState.vertexShader = "clustered_vertex.spv";
+		m_pipelineState.fragmentShader = "clustered_fragment.spv";
+		m_pipelineState.cullMode = VK_CULL_MODE_NONE;
+	}
+	else if (m_settings.queuedDraws > 0)
+	{
+		m_pipelineState.vertexShader = "queue_vertex.spv";
+		m_pipelineState.fragmentShader = "queue_fragment.spv";
+		m_pipelineState.cullMode = VK_CULL_MODE_NONE;
+		m_pipelineState.vertexStride = sizeof(glm::vec2);
+		m_pipelineState.specializationConstants = { 0 };
+	}
+	else
+	{
+		m_pipelineState.vertexShader = "vertex.spv";
+		m_pipelineState.fragmentShader = "fragment.spv";
+	}
+
+	m_pipelineState.dynamicViewport = m_settings.dynamicResolution || m_windows.size() > 1;
+}
+
+void Engine::readShaderFiles()
+{
+	std::vector<std::string> fileNames = { m_pipelineState.vertexShader, m_pipelineState.fragmentShader,
+		"hud_vertex.spv", "hud_fragment.spv" };
+
+	if (m_settings.occlusionCulling)
+	{
+		fileNames.push_back("occlusion_cull.spv");
+		fileNames.push_back("depth_pyramid.spv");
+	}
+
+	if (m_settings.particles)
+	{
+		fileNames.push_back("particle_simulate.spv");
+		fileNames.push_back("radix_histogram.spv");
+		fileNames.push_back("radix_scan.spv");
+		fileNames.push_back("radix_scatter.spv");
+	}
+
+	if (m_settings.clusteredLighting)
+	{
+		fileNames.push_back("light_binning.spv");
+	}
+
+	for (const std::string& fileName : fileNames)
+	{
+		m_shaderCode[fileName] = readShaderFile(fileName.c_str());
+	}
+}
+
 void Engine::createGraphicsPipeline()
 {
-	VkShaderModule vertexShader = loadShader("vertex.spv");
-	VkShaderModule fragmentShader = loadShader("fragment.spv");
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(glm::mat4);
+
+	if (m_settings.occlusionCulling)
+	{
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_vkSceneDescriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	}
+	else if (m_settings.particles)
+	{
+		pushConstantRange.size = sizeof(glm::mat4) + sizeof(glm::vec4);
+
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_vkParticleDrawDescriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	}
+	else if (m_settings.clusteredLighting)
+	{
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_vkLightingDescriptorSetLayout;
+	}
+	else if (m_settings.queuedDraws > 0)
+	{
+		pushConstantRange.size = sizeof(glm::vec4);
+
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_vkQueuedDrawDescriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	}
+
+	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheInfo = {};
+	pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	result = vkCreatePipelineCache(m_vkDevice, &pipelineCacheInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkPipelineCache);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline cache.");
+	}
+
+	m_pipelineVariants.reset(new PipelineVariants(m_vkDevice, hostAllocator(MemorySubsystem::Pipelines), *m_threadPool,
+		[this](const GraphicsPipelineState& state)
+		{
+			return buildGraphicsPipeline(state, m_vkPipelineLayout, m_vkRenderPass);
+		}));
+
+	m_vkFallbackPipeline = m_pipelineVariants->compile(m_pipelineState);
+
+	if (m_settings.occlusionCulling)
+	{
+		setSceneFog(m_settings.sceneFog);
+	}
+}
+
+VkPipeline Engine::buildGraphicsPipeline(const GraphicsPipelineState& state, VkPipelineLayout pipelineLayout, VkRenderPass renderPass)
+{
+	VkShaderModule vertexShader = loadShader(state.vertexShader.c_str());
+	VkShaderModule fragmentShader = loadShader(state.fragmentShader.c_str());
+
+	std::vector<VkSpecializationMapEntry> specializationEntries(state.specializationConstants.size());
+
+	for (uint32_t i = 0; i < specializationEntries.size(); ++i)
+	{
+		specializationEntries[i].constantID = i;
+		specializationEntries[i].offset = i * sizeof(uint32_t);
+		specializationEntries[i].size = sizeof(uint32_t);
+	}
+
+	VkSpecializationInfo specializationInfo = {};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+	specializationInfo.pMapEntries = specializationEntries.data();
+	specializationInfo.dataSize = state.specializationConstants.size() * sizeof(uint32_t);
+	specializationInfo.pData = state.specializationConstants.data();
 
 	VkPipelineShaderStageCreateInfo vertexStageCreateInfo = {};
 	vertexStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertexStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
 	vertexStageCreateInfo.module = vertexShader;
 	vertexStageCreateInfo.pName = "main";
+	vertexStageCreateInfo.pSpecializationInfo = &specializationInfo;
 
 	VkPipelineShaderStageCreateInfo fragmentStageCreateInfo = {};
 	fragmentStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	fragmentStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragmentStageCreateInfo.module = fragmentShader;
 	fragmentStageCreateInfo.pName = "main";
+	fragmentStageCreateInfo.pSpecializationInfo = &specializationInfo;
 
 	VkPipelineShaderStageCreateInfo shaderStageInfos[] = { vertexStageCreateInfo, fragmentStageCreateInfo };
 
+	VkVertexInputBindingDescription vertexBinding = {};
+	vertexBinding.binding = 0;
+	vertexBinding.stride = state.vertexStride;
+	vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	VkVertexInputAttributeDescription positionAttribute = {};
+	positionAttribute.location = 0;
+	positionAttribute.binding = 0;
+	positionAttribute.format = VK_FORMAT_R32G32_SFLOAT;
+	positionAttribute.offset = 0;
+
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
+	if (state.vertexStride != 0)
+	{
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+		vertexInputInfo.vertexAttributeDescriptionCount = 1;
+		vertexInputInfo.pVertexAttributeDescriptions = &positionAttribute;
+	}
+
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo = {};
 	inputAssemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssemblyCreateInfo.topology = state.topology;
 	inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
 
 	VkViewport viewport = {};
@@ -321,8 +676,8 @@ void Engine::createGraphicsPipeline()
 	rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
 	rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
 	rasterizationStateCreateInfo.lineWidth = 1.0f;
-	rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizationStateCreateInfo.cullMode = state.cullMode;
+	rasterizationStateCreateInfo.frontFace = state.frontFace;
 	rasterizationStateCreateInfo.depthBiasEnable = VK_FALSE;
 	rasterizationStateCreateInfo.depthBiasClamp = 0.0f;
 	rasterizationStateCreateInfo.depthBiasSlopeFactor = 0.0f;
@@ -339,9 +694,10 @@ void Engine::createGraphicsPipeline()
 	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
 		VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE;
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.blendEnable = state.blendEnable ? VK_TRUE : VK_FALSE;
+	colorBlendAttachment.srcColorBlendFactor = state.blendEnable ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstColorBlendFactor = state.blendEnable ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
 	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
 	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
@@ -357,14 +713,20 @@ void Engine::createGraphicsPipeline()
 	colorBlendState.blendConstants[2] = 0.0f;
 	colorBlendState.blendConstants[3] = 0.0f;
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+	depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencilState.depthTestEnable = VK_TRUE;
+	depthStencilState.depthWriteEnable = VK_TRUE;
+	depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencilState.depthBoundsTestEnable = VK_FALSE;
+	depthStencilState.stencilTestEnable = VK_FALSE;
 
-	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, nullptr, &m_vkPipelineLayout);
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create pipeline layout.");
-	}
+	VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
 
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -375,23 +737,52 @@ void Engine::createGraphicsPipeline()
 	pipelineInfo.pViewportState = &viewportStateCreateInfo;
 	pipelineInfo.pRasterizationState = &rasterizationStateCreateInfo;
 	pipelineInfo.pMultisampleState = &multisamplingStateCreateInfo;
-	pipelineInfo.pDepthStencilState = nullptr;
+	pipelineInfo.pDepthStencilState = state.depthTest ? &depthStencilState : nullptr;
 	pipelineInfo.pColorBlendState = &colorBlendState;
-	pipelineInfo.pDynamicState = nullptr;
-	pipelineInfo.layout = m_vkPipelineLayout;
-	pipelineInfo.renderPass = m_vkRenderPass;
+	pipelineInfo.pDynamicState = state.dynamicViewport ? &dynamicState : nullptr;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	result = vkCreateGraphicsPipelines(m_vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_vkPipeline);
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines(m_vkDevice, m_vkPipelineCache, 1, &pipelineInfo, hostAllocator(MemorySubsystem::Pipelines), &pipeline);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create graphics pipeline.");
 	}
 
-	vkDestroyShaderModule(m_vkDevice, vertexShader, nullptr);
-	vkDestroyShaderModule(m_vkDevice, fragmentShader, nullptr);
+	vkDestroyShaderModule(m_vkDevice, vertexShader, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyShaderModule(m_vkDevice, fragmentShader, hostAllocator(MemorySubsystem::Pipelines));
+
+	return pipeline;
+}
+
+VkPipeline Engine::createComputePipeline(const char* fileName, VkPipelineLayout pipelineLayout)
+{
+	VkShaderModule computeShader = loadShader(fileName);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeShader;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines(m_vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, hostAllocator(MemorySubsystem::Pipelines), &pipeline);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create compute pipeline.");
+	}
+
+	vkDestroyShaderModule(m_vkDevice, computeShader, hostAllocator(MemorySubsystem::Pipelines));
+
+	return pipeline;
 }
 
 void Engine::createFramebuffers()
@@ -401,7 +792,7 @@ void Engine::createFramebuffers()
 	VkFramebufferCreateInfo framebufferCreateInfo = {};
 	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 	framebufferCreateInfo.renderPass = m_vkRenderPass;
-	framebufferCreateInfo.attachmentCount = 1;
+	framebufferCreateInfo.attachmentCount = m_settings.occlusionCulling ? 2 : 1;
 	framebufferCreateInfo.width = m_vkSwapchainExtent.width;
 	framebufferCreateInfo.height = m_vkSwapchainExtent.height;
 	framebufferCreateInfo.layers = 1;
@@ -409,12 +800,13 @@ void Engine::createFramebuffers()
 	for (int i = 0; i < m_vkSwapchainImageViews.size(); ++i)
 	{
 		VkImageView attachments[] = {
-			m_vkSwapchainImageViews[i]
+			m_vkSwapchainImageViews[i],
+			m_vkDepthImageView
 		};
 
 		framebufferCreateInfo.pAttachments = attachments;
 
-		VkResult result = vkCreateFramebuffer(m_vkDevice, &framebufferCreateInfo, nullptr, &m_vkSwapchainFramebuffers[i]);
+		VkResult result = vkCreateFramebuffer(m_vkDevice, &framebufferCreateInfo, hostAllocator(MemorySubsystem::Swapchain), &m_vkSwapchainFramebuffers[i]);
 		if (result != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create swap chain frame buffer.");
@@ -429,8 +821,9 @@ void Engine::createCommandPool()
 	VkCommandPoolCreateInfo commandPoolCreateInfo = {};
 	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndices.graphics.value();
+	commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-	VkResult result = vkCreateCommandPool(m_vkDevice, &commandPoolCreateInfo, nullptr, &m_vkCommandPool);
+	VkResult result = vkCreateCommandPool(m_vkDevice, &commandPoolCreateInfo, hostAllocator(MemorySubsystem::Commands), &m_vkCommandPool);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create command pool.");
@@ -452,90 +845,154 @@ void Engine::createCommandBuffers()
 	{
 		throw std::runtime_error("Failed to allocate command buffers.");
 	}
+}
+
+void Engine::recordCommandBuffer(uint32_t imageIndex, VkPipeline pipeline, int captureSlot, const HudReadout& hud)
+{
+	VkCommandBuffer commandBuffer = m_vkCommandBuffers[imageIndex];
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin command buffer.");
+	}
+
+	writeFrameTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
 
-	for (size_t i = 0; i < m_vkCommandBuffers.size(); ++i)
+	if (m_settings.occlusionCulling)
 	{
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		
-		result = vkBeginCommandBuffer(m_vkCommandBuffers[i], &beginInfo);
-		if (result != VK_SUCCESS)
+		recordOcclusionCommands(commandBuffer, imageIndex, pipeline);
+	}
+	else
+	{
+		if (m_settings.particles)
 		{
-			throw std::runtime_error("Failed to begin command buffer.");
+			if (!m_computeQueueFamily.has_value())
+			{
+				recordParticleCompute(commandBuffer);
+			}
+
+			if (m_vkParticleQueryPool != VK_NULL_HANDLE)
+			{
+				vkCmdResetQueryPool(commandBuffer, m_vkParticleQueryPool,
+					m_currentFrame * PARTICLE_TIMESTAMP_COUNT + 3, 2);
+			}
+		}
+
+		if (m_settings.clusteredLighting)
+		{
+			recordLightBinning(commandBuffer);
 		}
 
+		VkExtent2D renderExtent = getRenderExtent();
+
 		VkRenderPassBeginInfo renderPassInfo = {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = m_vkRenderPass;
-		renderPassInfo.framebuffer = m_vkSwapchainFramebuffers[i];
+		renderPassInfo.renderPass = m_settings.dynamicResolution ? m_vkScaledRenderPass : m_vkRenderPass;
+		renderPassInfo.framebuffer = m_settings.dynamicResolution ? m_vkScaledFramebuffer : m_vkSwapchainFramebuffers[imageIndex];
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = m_vkSwapchainExtent;
+		renderPassInfo.renderArea.extent = renderExtent;
 
 		VkClearValue clearValue = { 0.0f, 0.0f, 0.0f, 1.0f };
 
 		renderPassInfo.clearValueCount = 1;
 		renderPassInfo.pClearValues = &clearValue;
 
-		vkCmdBeginRenderPass(m_vkCommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(m_vkCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_vkPipeline);
-		vkCmdDraw(m_vkCommandBuffers[i], 3, 1, 0, 0);
-		vkCmdEndRenderPass(m_vkCommandBuffers[i]);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		result = vkEndCommandBuffer(m_vkCommandBuffers[i]);
-		if (result != VK_SUCCESS)
+		if (m_pipelineState.dynamicViewport)
 		{
-			throw std::runtime_error("Failed to record command buffer.");
+			VkViewport viewport = {};
+			viewport.x = 0.0f;
+			viewport.y = 0.0f;
+			viewport.width = static_cast<float>(renderExtent.width);
+			viewport.height = static_cast<float>(renderExtent.height);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &renderPassInfo.renderArea);
 		}
-	}
-
-
-}
-
-void Engine::createSemaphores()
-{
-	m_vkImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	m_vkRenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 
-	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
-	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
-	{
-		VkResult result = vkCreateSemaphore(m_vkDevice, &semaphoreCreateInfo, nullptr, &m_vkImageAvailableSemaphores[i]);
-		if (result != VK_SUCCESS)
+		if (m_settings.particles)
+		{
+			recordParticleDraw(commandBuffer, pipeline);
+		}
+		else if (m_settings.clusteredLighting)
+		{
+			recordLitDraw(commandBuffer, pipeline);
+		}
+		else if (m_settings.queuedDraws > 0)
+		{
+			recordQueuedDraws(commandBuffer);
+		}
+		else
 		{
-			throw std::runtime_error("Failed to create image available semaphore.");
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			++m_pendingFrameStats[m_currentFrame].drawCount;
 		}
 
-		result = vkCreateSemaphore(m_vkDevice, &semaphoreCreateInfo, nullptr, &m_vkRenderFinishedSemaphores[i]);
-		if (result != VK_SUCCESS)
+		vkCmdEndRenderPass(commandBuffer);
+
+		if (m_settings.dynamicResolution)
 		{
-			throw std::runtime_error("Failed to create render finished semaphore.");
+			recordUpscale(commandBuffer, imageIndex, renderExtent);
 		}
 	}
 
+	recordHud(commandBuffer, imageIndex, hud);
+
+	if (captureSlot >= 0)
+	{
+		recordCaptureCopy(commandBuffer, imageIndex, captureSlot);
+	}
+
+	writeFrameTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 3);
+
+	result = vkEndCommandBuffer(commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer.");
+	}
 }
 
-void Engine::createFences()
+void Engine::createSyncObjects()
 {
-	m_vkFences.resize(MAX_FRAMES_IN_FLIGHT);
-	m_vkImagesInFlightFences.resize(m_vkSwapchainImages.size(), VK_NULL_HANDLE);
+	m_graphicsTimeline.reset(new TimelineSemaphore(m_vkDevice, hostAllocator(MemorySubsystem::Sync)));
+	m_frameTimelineValues.assign(MAX_FRAMES_IN_FLIGHT, 0);
+	m_imageTimelineValues.assign(m_vkSwapchainImages.size(), 0);
 
-	VkFenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	for (EngineWindow& window : m_windows)
 	{
-		VkResult result = vkCreateFence(m_vkDevice, &fenceCreateInfo, nullptr, &m_vkFences[i]);
-		if (result != VK_SUCCESS)
+		window.imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+		window.renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
 		{
-			throw std::runtime_error("Failed to create fance.");
+			VkResult result = vkCreateSemaphore(m_vkDevice, &semaphoreCreateInfo, hostAllocator(MemorySubsystem::Sync), &window.imageAvailableSemaphores[i]);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create image available semaphore.");
+			}
+
+			result = vkCreateSemaphore(m_vkDevice, &semaphoreCreateInfo, hostAllocator(MemorySubsystem::Sync), &window.renderFinishedSemaphores[i]);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create render finished semaphore.");
+			}
 		}
 	}
 }
 
-VkShaderModule Engine::loadShader(const char* fileName)
+std::vector<char> Engine::readShaderFile(const char* fileName)
 {
 	std::ifstream istr(fileName, std::ios::ate | std::ios::binary);
 
@@ -550,13 +1007,21 @@ VkShaderModule Engine::loadShader(const char* fileName)
 	istr.read(buffer.data(), fileSize);
 	istr.close();
 
-	VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+	return buffer;
+}
+
+VkShaderModule Engine::loadShader(const char* fileName)
+{
+	auto cached = m_shaderCode.find(fileName);
+	std::vector<char> buffer = cached != m_shaderCode.end() ? cached->second : readShaderFile(fileName);
+
+	VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
 	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	shaderModuleCreateInfo.codeSize = fileSize;
+	shaderModuleCreateInfo.codeSize = buffer.size();
 	shaderModuleCreateInfo.pCode = reinterpret_cast<uint32_t*>(buffer.data());
 
 	VkShaderModule shaderModule;
-	VkResult result = vkCreateShaderModule(m_vkDevice, &shaderModuleCreateInfo, nullptr, &shaderModule);
+	VkResult result = vkCreateShaderModule(m_vkDevice, &shaderModuleCreateInfo, hostAllocator(MemorySubsystem::Pipelines), &shaderModule);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create shader module.");
@@ -565,6 +1030,206 @@ VkShaderModule Engine::loadShader(const char* fileName)
 	return shaderModule;
 }
 
+void Engine::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+	VkBuffer& buffer, VkDeviceMemory& memory, MemorySubsystem subsystem)
+{
+	VkBufferCreateInfo bufferCreateInfo = {};
+	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCreateInfo.size = size;
+	bufferCreateInfo.usage = usage;
+	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	// Storage buffers may be written on the async compute queue and read on
+	// the graphics queue, so they are shared instead of transferring ownership.
+	if ((usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) && !m_computeSharingFamilies.empty())
+	{
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(m_computeSharingFamilies.size());
+		bufferCreateInfo.pQueueFamilyIndices = m_computeSharingFamilies.data();
+	}
+
+	VkResult result = vkCreateBuffer(m_vkDevice, &bufferCreateInfo, hostAllocator(subsystem), &buffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create buffer.");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(m_vkDevice, buffer, &memoryRequirements);
+
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = memoryRequirements.size;
+	allocateInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, properties);
+
+	result = vkAllocateMemory(m_vkDevice, &allocateInfo, hostAllocator(subsystem), &memory);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate buffer memory.");
+	}
+
+	m_memoryTracker->recordDeviceAllocation(memory, allocateInfo.memoryTypeIndex, allocateInfo.allocationSize, subsystem);
+
+	vkBindBufferMemory(m_vkDevice, buffer, memory, 0);
+
+	recordResource({ CommandStreamResourceKind::Buffer, static_cast<uint32_t>(subsystem), size,
+		0, 0, 0, 0, usage, properties });
+}
+
+void Engine::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format,
+	VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, MemorySubsystem subsystem)
+{
+	VkImageCreateInfo imageCreateInfo = {};
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.format = format;
+	imageCreateInfo.extent.width = width;
+	imageCreateInfo.extent.height = height;
+	imageCreateInfo.extent.depth = 1;
+	imageCreateInfo.mipLevels = mipLevels;
+	imageCreateInfo.arrayLayers = 1;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.usage = usage;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkResult result = vkCreateImage(m_vkDevice, &imageCreateInfo, hostAllocator(subsystem), &image);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create image.");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(m_vkDevice, image, &memoryRequirements);
+
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = memoryRequirements.size;
+	allocateInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	result = vkAllocateMemory(m_vkDevice, &allocateInfo, hostAllocator(subsystem), &memory);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate image memory.");
+	}
+
+	m_memoryTracker->recordDeviceAllocation(memory, allocateInfo.memoryTypeIndex, allocateInfo.allocationSize, subsystem);
+
+	vkBindImageMemory(m_vkDevice, image, memory, 0);
+
+	recordResource({ CommandStreamResourceKind::Image, static_cast<uint32_t>(subsystem), 0,
+		width, height, mipLevels, static_cast<uint32_t>(format), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT });
+}
+
+VkImageView Engine::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask,
+	uint32_t baseMipLevel, uint32_t levelCount)
+{
+	VkImageViewCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.image = image;
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format = format;
+	createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.subresourceRange.aspectMask = aspectMask;
+	createInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	createInfo.subresourceRange.levelCount = levelCount;
+	createInfo.subresourceRange.baseArrayLayer = 0;
+	createInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	VkResult result = vkCreateImageView(m_vkDevice, &createInfo, hostAllocator(MemorySubsystem::RenderTargets), &imageView);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create image view.");
+	}
+
+	return imageView;
+}
+
+uint32_t Engine::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(m_vkPhysicalDevice, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	{
+		if ((typeFilter & (1 << i)) &&
+			(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return i;
+		}
+	}
+
+	throw std::runtime_error("Suitable memory type not found.");
+}
+
+void Engine::freeDeviceMemory(VkDeviceMemory memory)
+{
+	m_memoryTracker->recordDeviceFree(memory);
+	vkFreeMemory(m_vkDevice, memory, hostAllocator(MemorySubsystem::Core));
+}
+
+const VkAllocationCallbacks* Engine::hostAllocator(MemorySubsystem subsystem) const
+{
+	return m_memoryTracker->getAllocationCallbacks(subsystem);
+}
+
+VkCommandBuffer Engine::beginSingleTimeCommands()
+{
+	VkCommandBufferAllocateInfo commandBufferInfo = {};
+	commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferInfo.commandPool = m_vkCommandPool;
+	commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	VkResult result = vkAllocateCommandBuffers(m_vkDevice, &commandBufferInfo, &commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate command buffers.");
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin command buffer.");
+	}
+
+	return commandBuffer;
+}
+
+void Engine::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+{
+	VkResult result = vkEndCommandBuffer(commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer.");
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	result = vkQueueSubmit(m_vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to queue submit.");
+	}
+
+	vkQueueWaitIdle(m_vkGraphicsQueue);
+	vkFreeCommandBuffers(m_vkDevice, m_vkCommandPool, 1, &commandBuffer);
+}
+
 QueueFamilyIndices Engine::findQueueFamilyIndices(VkPhysicalDevice physicalDevice)
 {
 	QueueFamilyIndices queueFamilyIndices;
@@ -578,17 +1243,30 @@ QueueFamilyIndices Engine::findQueueFamilyIndices(VkPhysicalDevice physicalDevic
 	unsigned int index = 0;
 	for (VkQueueFamilyProperties queueFamily : queueFamilies)
 	{
-		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !queueFamilyIndices.graphics.has_value())
 		{
-			if (!queueFamilyIndices.graphics.has_value())
+			queueFamilyIndices.graphics = index;
+
+			if (m_settings.headless)
 			{
-				queueFamilyIndices.graphics = index;
+				queueFamilyIndices.presentation = index;
 			}
 		}
-		else if (!queueFamilyIndices.presentation.has_value())
+
+		// Integrated and software devices usually have a single family that
+		// both draws and presents, so graphics families are candidates too.
+		if (!queueFamilyIndices.presentation.has_value())
 		{
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, index, m_vkSurface, &presentSupport);
+			// All swap chains are presented in one call, so one family has to
+			// present to every window.
+			VkBool32 presentSupport = !m_windows.empty();
+
+			for (const EngineWindow& window : m_windows)
+			{
+				VkBool32 windowSupport = false;
+				vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, index, window.surface, &windowSupport);
+				presentSupport = presentSupport && windowSupport;
+			}
 
 			if (presentSupport)
 			{
@@ -604,32 +1282,52 @@ QueueFamilyIndices Engine::findQueueFamilyIndices(VkPhysicalDevice physicalDevic
 		++index;
 	}
 
-	throw std::runtime_error("Graphics with presentation queue family not found.");
+	return queueFamilyIndices;
 }
 
-SwapChainSupportDetails Engine::querySwapChainSupport(VkPhysicalDevice physicalDevice)
+std::optional<uint32_t> Engine::findAsyncComputeQueueFamily(VkPhysicalDevice physicalDevice)
+{
+	unsigned int familyCount;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queueFamilies(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, queueFamilies.data());
+
+	for (uint32_t index = 0; index < familyCount; ++index)
+	{
+		if ((queueFamilies[index].queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+			!(queueFamilies[index].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			return index;
+		}
+	}
+
+	return std::nullopt;
+}
+
+SwapChainSupportDetails Engine::querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
 {
 	SwapChainSupportDetails supportDetails;
 
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, m_vkSurface, &supportDetails.capabilities);
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &supportDetails.capabilities);
 
 	uint32_t formatCount;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, m_vkSurface, &formatCount, nullptr);
+	vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
 
 	if (formatCount > 0)
 	{
 		supportDetails.formats.resize(formatCount);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, m_vkSurface, &formatCount, supportDetails.formats.data());
+		vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, supportDetails.formats.data());
 	}
 
 	uint32_t presentModeCount;
-	vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, m_vkSurface, &presentModeCount, nullptr);
+	vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
 
 	if (presentModeCount > 0)
 	{
 		supportDetails.presentModes.resize(presentModeCount);
 		vkGetPhysicalDeviceSurfacePresentModesKHR(
-			physicalDevice, m_vkSurface, &presentModeCount, supportDetails.presentModes.data());
+			physicalDevice, surface, &presentModeCount, supportDetails.presentModes.data());
 	}
 
 	return supportDetails;
@@ -645,17 +1343,17 @@ VkPresentModeKHR Engine::chooseSwapPresentMode(const std::vector<VkPresentModeKH
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-VkExtent2D Engine::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
+VkExtent2D Engine::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, struct SDL_Window* sdlWindow)
 {
 	VkExtent2D extent;
 
 	if (capabilities.currentExtent.width == UINT32_MAX)
 	{
 		int width, height;
-		SDL_Vulkan_GetDrawableSize(m_sdlWindow, &width, &height);
+		SDL_Vulkan_GetDrawableSize(sdlWindow, &width, &height);
 
-		glm::clamp(static_cast<uint32_t>(height), capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
-		glm::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+		extent.height = glm::clamp(static_cast<uint32_t>(height), capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+		extent.width = glm::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
 	}
 	else
 	{
@@ -665,6 +1363,24 @@ VkExtent2D Engine::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities
 	return extent;
 }
 
+bool Engine::checkInstanceExtensionSupport(const char* extensionName)
+{
+	uint32_t availableExtensionCount;
+	vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionCount, availableExtensions.data());
+
+	for (VkExtensionProperties& available : availableExtensions)
+	{
+		if (strcmp(available.extensionName, extensionName) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool Engine::checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
 {
 	uint32_t availableExtensionCount;
@@ -682,11 +1398,36 @@ bool Engine::checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
 	return unavailableExtensions.empty();
 }
 
+bool Engine::checkMemoryBudgetSupport(VkPhysicalDevice physicalDevice)
+{
+	uint32_t availableExtensionCount;
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &availableExtensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &availableExtensionCount, availableExtensions.data());
+
+	for (VkExtensionProperties& available : availableExtensions)
+	{
+		if (strcmp(available.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool Engine::checkSwapchainSupport(VkPhysicalDevice physicalDevice)
 {
-	SwapChainSupportDetails swapchainSupportDetails = querySwapChainSupport(physicalDevice);
-	return !swapchainSupportDetails.presentModes.empty() &&
-		!swapchainSupportDetails.formats.empty();
+	for (const EngineWindow& window : m_windows)
+	{
+		SwapChainSupportDetails swapchainSupportDetails = querySwapChainSupport(physicalDevice, window.surface);
+		if (swapchainSupportDetails.presentModes.empty() || swapchainSupportDetails.formats.empty())
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 bool Engine::checkQueueFamiliesSupport(VkPhysicalDevice physicalDevice)
@@ -695,29 +1436,364 @@ bool Engine::checkQueueFamiliesSupport(VkPhysicalDevice physicalDevice)
 	return indices.graphics.has_value() && indices.presentation.has_value();
 }
 
-Engine::Engine()
-	: MAX_FRAMES_IN_FLIGHT(2)
+bool Engine::checkTimelineSemaphoreSupport(VkPhysicalDevice physicalDevice)
+{
+	PFN_vkGetPhysicalDeviceFeatures2KHR getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+		vkGetInstanceProcAddr(m_vkInstance, "vkGetPhysicalDeviceFeatures2KHR"));
+
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+	timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2KHR features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+	features.pNext = &timelineSemaphoreFeatures;
+
+	getFeatures2(physicalDevice, &features);
+
+	return timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+}
+
+Engine::Engine(const EngineSettings& settings)
+	: MAX_FRAMES_IN_FLIGHT(2),
+	OCCLUSION_TIMESTAMP_COUNT(6),
+	CAPTURE_RING_SIZE(6),
+	MEMORY_STATS_INTERVAL(60),
+	PARTICLE_TIMESTAMP_COUNT(5),
+	FRAME_TIMESTAMP_COUNT(4),
+	HUD_MAX_VERTICES(12288),
+	HUD_HISTORY_SIZE(120),
+	LIGHTING_TIMESTAMP_COUNT(4),
+	m_settings(settings),
+	m_memoryTracker(new MemoryTracker(settings.memoryBudgetThreshold)),
+	m_memoryBudgetSupported(false),
+	m_replaySource(nullptr),
+	m_renderScale(1.0f),
+	m_renderScaleEstimate(1.0f)
 {
 }
 
 void Engine::init(SDL_Window* sdlWindow)
 {
-	m_sdlWindow = sdlWindow;
+	init(sdlWindow != nullptr ? std::vector<SDL_Window*>{ sdlWindow } : std::vector<SDL_Window*>());
+}
+
+void Engine::init(const std::vector<SDL_Window*>& sdlWindows)
+{
+	m_windows.clear();
+
+	if (!m_settings.headless)
+	{
+		m_windows.resize(sdlWindows.size());
+
+		for (size_t i = 0; i < sdlWindows.size(); ++i)
+		{
+			m_windows[i] = {};
+			m_windows[i].sdlWindow = sdlWindows[i];
+			m_windows[i].presenting = true;
+			m_windows[i].stats.presentInterval = i == 0 ? 1 : std::max(m_settings.viewportPresentInterval, 1u);
+		}
+
+		if (m_windows.empty())
+		{
+			throw std::runtime_error("Rendering to a window needs at least one window.");
+		}
+	}
+
 	m_currentFrame = 0;
+	m_frameNumber = 0;
+	m_frameImageIndices.assign(MAX_FRAMES_IN_FLIGHT, UINT32_MAX);
+	m_vkPresentLayout = m_settings.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	m_initStart = std::chrono::steady_clock::now();
+
+	if (m_settings.occlusionCulling && m_settings.particles)
+	{
+		throw std::runtime_error("Particles cannot be combined with occlusion culling.");
+	}
+
+	if (m_settings.occlusionCulling && m_settings.dynamicResolution)
+	{
+		throw std::runtime_error("Dynamic resolution cannot be combined with occlusion culling.");
+	}
+
+	if (m_settings.clusteredLighting && (m_settings.occlusionCulling || m_settings.particles))
+	{
+		throw std::runtime_error("Clustered lighting cannot be combined with occlusion culling or particles.");
+	}
+
+	if (m_settings.queuedDraws > 0 && (m_settings.occlusionCulling || m_settings.particles || m_settings.clusteredLighting))
+	{
+		throw std::runtime_error("Queued draws cannot be combined with occlusion culling, particles or clustered lighting.");
+	}
+
+	if (m_windows.size() > 1 && (m_settings.occlusionCulling || m_settings.particles || m_settings.clusteredLighting))
+	{
+		throw std::runtime_error("Additional windows cannot be combined with occlusion culling, particles or clustered lighting.");
+	}
+
+	if (!m_settings.commandStreamPath.empty() && m_replaySource == nullptr)
+	{
+		createCommandStream();
+	}
+
+	m_threadPool.reset(new ThreadPool(ThreadPool::defaultWorkerCount()));
+	choosePipelineState();
+
+	TaskGraph graph;
+
+	TaskGraph::TaskId shaders = graph.addTask("shaders", [this]()
+	{
+		readShaderFiles();
+	});
+
+	TaskGraph::TaskId instance = graph.addTask("instance", [this]()
+	{
+		initVkInstance();
+
+		if (!m_settings.headless)
+		{
+			createVkSurfaces();
+		}
+	}, {}, true);
+
+	TaskGraph::TaskId device = graph.addTask("device", [this]()
+	{
+		pickPhysicalDevice();
+		createDevice();
+	}, { instance });
+
+	TaskGraph::TaskId formats = graph.addTask("formats", [this]()
+	{
+		chooseSwapchainFormat();
+
+		if (m_settings.occlusionCulling)
+		{
+			chooseDepthFormat();
+		}
+	}, { device }, true);
+
+	TaskGraph::TaskId commandPool = graph.addTask("command pool", [this]()
+	{
+		createCommandPool();
+	}, { device });
+
+	TaskGraph::TaskId swapchain = graph.addTask("swap chain", [this]()
+	{
+		if (m_settings.headless)
+		{
+			createOffscreenImages();
+		}
+		else
+		{
+			for (EngineWindow& window : m_windows)
+			{
+				createSwapChain(window);
+			}
+
+			m_vkSwapchainImages = m_windows[0].images;
+		}
+
+		createSwapChainImageViews(m_vkSwapchainImages, m_vkSwapchainImageViews);
+	}, { formats });
+
+	TaskGraph::TaskId renderPass = graph.addTask("render pass", [this]()
+	{
+		if (m_settings.occlusionCulling)
+		{
+			createOcclusionRenderPasses();
+		}
+		else
+		{
+			createRenderPass();
+		}
+
+		if (m_settings.dynamicResolution)
+		{
+			createScaledRenderPass();
+		}
+
+		createHudRenderPass();
+	}, { formats });
+
+	std::vector<TaskGraph::TaskId> pipelineDependencies = { shaders, renderPass };
+	std::vector<TaskGraph::TaskId> framebufferDependencies = { swapchain, renderPass };
+	std::vector<TaskGraph::TaskId> commandBufferDependencies = { commandPool };
+
+	if (m_settings.occlusionCulling)
+	{
+		TaskGraph::TaskId setLayouts = graph.addTask("descriptor set layouts", [this]()
+		{
+			createOcclusionDescriptorSetLayouts();
+		}, { device });
+
+		TaskGraph::TaskId depth = graph.addTask("depth buffer", [this]()
+		{
+			createDepthResources();
+		}, { formats });
+
+		TaskGraph::TaskId sceneResources = graph.addTask("scene resources", [this]()
+		{
+			createOcclusionResources();
+		}, { swapchain, depth, setLayouts, commandPool });
+
+		pipelineDependencies.push_back(setLayouts);
+		framebufferDependencies.push_back(depth);
+		commandBufferDependencies.push_back(sceneResources);
+	}
+
+	if (m_settings.particles)
+	{
+		TaskGraph::TaskId setLayouts = graph.addTask("particle set layouts", [this]()
+		{
+			createParticleDescriptorSetLayouts();
+		}, { device });
+
+		TaskGraph::TaskId particleResources = graph.addTask("particle resources", [this]()
+		{
+			createParticleResources();
+		}, { swapchain, setLayouts, commandPool });
+
+		pipelineDependencies.push_back(setLayouts);
+		commandBufferDependencies.push_back(particleResources);
+	}
+
+	if (m_settings.clusteredLighting)
+	{
+		TaskGraph::TaskId setLayout = graph.addTask("lighting set layout", [this]()
+		{
+			createLightingDescriptorSetLayout();
+		}, { device });
+
+		TaskGraph::TaskId lightingResources = graph.addTask("lighting resources", [this]()
+		{
+			createLightingResources();
+		}, { swapchain, setLayout });
+
+		pipelineDependencies.push_back(setLayout);
+		commandBufferDependencies.push_back(lightingResources);
+	}
+
+	if (m_settings.queuedDraws > 0)
+	{
+		TaskGraph::TaskId setLayout = graph.addTask("queued draw set layout", [this]()
+		{
+			createQueuedDrawDescriptorSetLayout();
+		}, { device });
+
+		TaskGraph::TaskId queuedDrawResources = graph.addTask("queued draw resources", [this]()
+		{
+			createQueuedDrawResources();
+		}, { device, setLayout });
+
+		pipelineDependencies.push_back(setLayout);
+		commandBufferDependencies.push_back(queuedDrawResources);
+	}
+
+	TaskGraph::TaskId hudSetLayout = graph.addTask("hud set layout", [this]()
+	{
+		createHudDescriptorSetLayout();
+	}, { device });
+
+	// The font upload shares the graphics command pool with the scene and
+	// particle uploads, so it runs after them.
+	std::vector<TaskGraph::TaskId> hudDependencies = commandBufferDependencies;
+	hudDependencies.push_back(swapchain);
+	hudDependencies.push_back(hudSetLayout);
+
+	TaskGraph::TaskId hudResources = graph.addTask("hud resources", [this]()
+	{
+		createHudResources();
+	}, hudDependencies);
+
+	pipelineDependencies.push_back(hudSetLayout);
+	commandBufferDependencies.push_back(hudResources);
+
+	graph.addTask("pipelines", [this]()
+	{
+		if (m_settings.occlusionCulling)
+		{
+			createOcclusionPipelines();
+		}
+
+		if (m_settings.particles)
+		{
+			createParticlePipelines();
+		}
+
+		if (m_settings.clusteredLighting)
+		{
+			createLightingPipelines();
+		}
+
+		createGraphicsPipeline();
+
+		if (m_settings.queuedDraws > 0)
+		{
+			createQueuedDrawPipelines();
+		}
+
+		createHudPipeline();
+	}, pipelineDependencies);
+
+	TaskGraph::TaskId framebuffers = graph.addTask("framebuffers", [this]()
+	{
+		createFramebuffers();
+		createHudFramebuffers();
+
+		if (m_settings.dynamicResolution)
+		{
+			createScaledRenderTarget();
+		}
+	}, framebufferDependencies);
+
+	commandBufferDependencies.push_back(framebuffers);
+
+	// Viewport command buffers come from the graphics command pool too, so
+	// they are allocated after every other user of the pool.
+	if (m_windows.size() > 1)
+	{
+		std::vector<TaskGraph::TaskId> viewportDependencies = commandBufferDependencies;
+		viewportDependencies.push_back(swapchain);
+		viewportDependencies.push_back(renderPass);
+
+		TaskGraph::TaskId viewports = graph.addTask("viewports", [this]()
+		{
+			createViewportTargets();
+		}, viewportDependencies);
+
+		commandBufferDependencies.push_back(viewports);
+	}
+
+	graph.addTask("command buffers", [this]()
+	{
+		createCommandBuffers();
+	}, commandBufferDependencies);
+
+	graph.addTask("sync objects", [this]()
+	{
+		createSyncObjects();
+	}, { swapchain });
+
+	if (m_settings.captureFormat != CaptureFormat::None)
+	{
+		graph.addTask("capture", [this]()
+		{
+			createCaptureResources();
+		}, { swapchain });
+	}
 
-	initVkInstance();
-	createVkSurface();
-	pickPhysicalDevice();
-	createDevice();
-	createSwapChain();
-	createSwapChainImageViews();
-	createRenderPass();
-	createGraphicsPipeline();
-	createFramebuffers();
-	createCommandPool();
-	createCommandBuffers();
-	createSemaphores();
-	createFences();
+	graph.run(m_settings.parallelInit ? m_threadPool.get() : nullptr);
+
+	if (m_replaySource != nullptr)
+	{
+		compileReplayPipelines();
+	}
+
+	m_memoryTracker->update(m_frameNumber);
+
+	m_startupStats.phases = graph.getTimings();
+	m_startupStats.initTimeMs = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - m_initStart).count();
+	m_startupStats.timeToFirstFrameMs = 0.0;
 }
 
 void Engine::update()
@@ -726,61 +1802,230 @@ void Engine::update()
 
 void Engine::render()
 {
-	vkWaitForFences(m_vkDevice, 1, &m_vkFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+	renderFrame(nullptr);
+}
 
-	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(m_vkDevice, m_vkSwapchain, UINT64_MAX,
-		m_vkImageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+void Engine::renderFrame(const CommandStreamFrame* replayFrame)
+{
+	double frameTimeMs = measureFrameTime();
 
-	if (result != VK_SUCCESS)
+	m_graphicsTimeline->wait(m_frameTimelineValues[m_currentFrame]);
+	m_graphicsTimeline->retire();
+
+	if (m_frameImageIndices[m_currentFrame] != UINT32_MAX)
 	{
-		throw std::runtime_error("Failed to acquire next image.");
+		collectFrameStats(m_currentFrame);
+
+		if (m_settings.dynamicResolution && replayFrame == nullptr)
+		{
+			updateRenderScale();
+		}
 	}
 
-	if (m_vkImagesInFlightFences[imageIndex] != VK_NULL_HANDLE)
+	if (m_settings.occlusionCulling && m_frameImageIndices[m_currentFrame] != UINT32_MAX)
 	{
-		vkWaitForFences(m_vkDevice, 1, &m_vkImagesInFlightFences[imageIndex], VK_TRUE, UINT64_MAX);
+		collectOcclusionStats(m_currentFrame);
 	}
 
-	VkSemaphore waitSemaphores[] = { m_vkImageAvailableSemaphores[m_currentFrame] };
-	VkSemaphore signalSemaphores[] = { m_vkRenderFinishedSemaphores[m_currentFrame] };
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	if (m_settings.particles && m_frameImageIndices[m_currentFrame] != UINT32_MAX)
+	{
+		collectParticleStats(m_currentFrame);
+	}
 
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_vkCommandBuffers[imageIndex];
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
+	if (m_settings.clusteredLighting && m_frameImageIndices[m_currentFrame] != UINT32_MAX)
+	{
+		collectLightingStats(m_currentFrame);
+	}
+
+	FrameStats& frameStats = m_pendingFrameStats[m_currentFrame];
+	frameStats = {};
+	frameStats.frameNumber = m_frameNumber;
+	frameStats.frameTimeMs = frameTimeMs;
+
+	uint32_t imageIndex = m_currentFrame;
+	VkResult result;
+
+	if (!m_settings.headless)
+	{
+		// The first window's targets are shared with the whole renderer, so
+		// an out of date swapchain there drops the frame rather than
+		// recreating them.
+		if (!acquireWindowImage(m_windows[0]))
+		{
+			m_frameImageIndices[m_currentFrame] = UINT32_MAX;
+			++m_windows[0].stats.skippedFrames;
+			return;
+		}
+
+		imageIndex = m_windows[0].imageIndex;
+	}
+
+	int captureSlot = -1;
+	if (m_settings.captureFormat != CaptureFormat::None)
+	{
+		captureSlot = acquireCaptureSlot();
+	}
+
+	m_graphicsTimeline->wait(m_imageTimelineValues[imageIndex]);
 
-	vkResetFences(m_vkDevice, 1, &m_vkFences[m_currentFrame]);
+	std::chrono::steady_clock::time_point cpuStart = std::chrono::steady_clock::now();
+
+	VkPipeline pipeline;
+	CommandStreamFrame frame;
+
+	if (replayFrame != nullptr)
+	{
+		// A replay draws with the variant the capture drew with, never with
+		// whichever one happens to finish compiling first.
+		frame = *replayFrame;
+		m_pipelineState.specializationConstants = frame.specializationConstants;
+		m_hudVisible = frame.hudVisible;
+		m_renderScale = frame.renderScale;
+		pipeline = frame.fallbackPipeline ? m_vkFallbackPipeline : m_pipelineVariants->compile(m_pipelineState);
+	}
+	else
+	{
+		pipeline = m_pipelineVariants->request(m_pipelineState, m_vkFallbackPipeline);
+
+		frame.frameNumber = m_frameNumber;
+		frame.fallbackPipeline = pipeline == m_vkFallbackPipeline;
+		frame.hudVisible = m_hudVisible;
+		frame.renderScale = m_renderScale;
+		frame.specializationConstants = m_pipelineState.specializationConstants;
+		frame.hud = readHud();
+
+		if (m_commandStreamWriter)
+		{
+			m_commandStreamWriter->writeFrame(frame);
+		}
+	}
+
+	frameStats.renderScale = m_renderScale;
+
+	if (m_settings.queuedDraws > 0)
+	{
+		sortQueuedDraws();
+	}
+
+	// Viewports are recorded first so the queue and HUD statistics describe
+	// the main window.
+	std::vector<VkCommandBuffer> commandBuffers = recordViewports(pipeline);
+
+	std::chrono::steady_clock::time_point recordStart = std::chrono::steady_clock::now();
+	recordCommandBuffer(imageIndex, pipeline, captureSlot, frame.hud);
+	commandBuffers.insert(commandBuffers.begin(), m_vkCommandBuffers[imageIndex]);
+
+	if (!m_windows.empty())
+	{
+		m_windows[0].stats.recordTimeMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - recordStart).count();
+	}
+
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkPipelineStageFlags> waitStages;
+	std::vector<uint64_t> waitValues;
+
+	for (EngineWindow& window : m_windows)
+	{
+		if (!window.presenting)
+		{
+			continue;
+		}
+
+		waitSemaphores.push_back(window.imageAvailableSemaphores[m_currentFrame]);
+		waitStages.push_back(m_settings.dynamicResolution && &window == &m_windows[0] ?
+			VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		waitValues.push_back(0);
+	}
+
+	if (m_settings.particles && m_computeQueueFamily.has_value())
+	{
+		waitSemaphores.push_back(m_computeTimeline->getHandle());
+		waitStages.push_back(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+		waitValues.push_back(submitParticleCompute());
+	}
 
-	result = vkQueueSubmit(m_vkGraphicsQueue, 1, &submitInfo, m_vkFences[m_currentFrame]);
+	uint64_t frameValue = m_graphicsTimeline->nextValue();
+
+	std::vector<VkSemaphore> signalSemaphores = { m_graphicsTimeline->getHandle() };
+	std::vector<uint64_t> signalValues = { frameValue };
+
+	for (EngineWindow& window : m_windows)
+	{
+		if (window.presenting)
+		{
+			signalSemaphores.push_back(window.renderFinishedSemaphores[m_currentFrame]);
+			signalValues.push_back(0);
+		}
+	}
+
+	VkTimelineSemaphoreSubmitInfoKHR timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	timelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+	submitInfo.pCommandBuffers = commandBuffers.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+	submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+	result = vkQueueSubmit(m_vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to queue submit.");
 	}
 
-	VkSwapchainKHR swapChains[] = { m_vkSwapchain };
+	frameStats.cpuTimeMs = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - cpuStart).count();
 
-	VkPresentInfoKHR presentInfo = {};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = signalSemaphores;
-	presentInfo.swapchainCount = 1;
-	presentInfo.pSwapchains = swapChains;
-	presentInfo.pImageIndices = &imageIndex;
+	m_frameTimelineValues[m_currentFrame] = frameValue;
+	m_imageTimelineValues[imageIndex] = frameValue;
+	m_frameImageIndices[m_currentFrame] = imageIndex;
 
-	result = vkQueuePresentKHR(m_vkPresentationQueue, &presentInfo);
-	if (result != VK_SUCCESS)
+	for (size_t i = 1; i < m_windows.size(); ++i)
 	{
-		throw std::runtime_error("Failed to queue presentation.");
+		if (m_windows[i].presenting)
+		{
+			m_windows[i].imageTimelineValues[m_windows[i].imageIndex] = frameValue;
+		}
 	}
 
-	vkQueueWaitIdle(m_vkPresentationQueue);
+	++m_frameNumber;
+
+	if (captureSlot >= 0)
+	{
+		m_graphicsTimeline->defer(frameValue, [this, captureSlot]()
+		{
+			submitCapturedFrame(captureSlot);
+		});
+	}
+
+	if (m_frameNumber == 1)
+	{
+		m_startupStats.timeToFirstFrameMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - m_initStart).count();
+	}
+
+	if (m_frameNumber % MEMORY_STATS_INTERVAL == 0)
+	{
+		m_memoryTracker->update(m_frameNumber);
+	}
+
+	if (m_settings.headless)
+	{
+		m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		return;
+	}
+
+	presentWindows();
 
 	m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
@@ -788,36 +2033,200 @@ void Engine::render()
 void Engine::cleanUp()
 {
 	vkDeviceWaitIdle(m_vkDevice);
+	m_graphicsTimeline->retire();
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
 	{
-		vkDestroySemaphore(m_vkDevice, m_vkImageAvailableSemaphores[i], nullptr);
-		vkDestroySemaphore(m_vkDevice, m_vkRenderFinishedSemaphores[i], nullptr);
-		vkDestroyFence(m_vkDevice, m_vkFences[i], nullptr);
+		int frameSlot = (m_currentFrame + i) % MAX_FRAMES_IN_FLIGHT;
+		if (m_frameImageIndices[frameSlot] != UINT32_MAX)
+		{
+			collectFrameStats(frameSlot);
+		}
 	}
 
-	for (VkFence imagesInFlightFence : m_vkImagesInFlightFences)
+	m_commandStreamWriter.reset();
+
+	if (m_settings.captureFormat != CaptureFormat::None)
 	{
-		vkDestroyFence(m_vkDevice, imagesInFlightFence, nullptr);
+		destroyCaptureResources();
 	}
 
-	vkDestroyCommandPool(m_vkDevice, m_vkCommandPool, nullptr);
-	vkDestroyPipeline(m_vkDevice, m_vkPipeline, nullptr);
-	vkDestroyPipelineLayout(m_vkDevice, m_vkPipelineLayout, nullptr);
-	vkDestroyRenderPass(m_vkDevice, m_vkRenderPass, nullptr);
-	vkDestroySwapchainKHR(m_vkDevice, m_vkSwapchain, nullptr);
+	m_graphicsTimeline->destroy();
+	m_graphicsTimeline.reset();
+
+	if (m_settings.occlusionCulling)
+	{
+		destroyOcclusionResources();
+	}
+
+	if (m_settings.particles)
+	{
+		destroyParticleResources();
+	}
+
+	if (m_settings.clusteredLighting)
+	{
+		destroyLightingResources();
+	}
+
+	if (m_settings.queuedDraws > 0)
+	{
+		destroyQueuedDrawResources();
+	}
+
+	destroyHudResources();
+
+	if (m_settings.dynamicResolution)
+	{
+		destroyScaledRenderTarget();
+	}
+
+	vkDestroyCommandPool(m_vkDevice, m_vkCommandPool, hostAllocator(MemorySubsystem::Commands));
+	m_pipelineVariants->destroy();
+	m_pipelineVariants.reset();
+	m_threadPool.reset();
+	vkDestroyPipelineCache(m_vkDevice, m_vkPipelineCache, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkPipelineLayout, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyRenderPass(m_vkDevice, m_vkRenderPass, hostAllocator(MemorySubsystem::Pipelines));
+
+	destroyWindows();
 
 	for (VkFramebuffer framebuffer : m_vkSwapchainFramebuffers)
 	{
-		vkDestroyFramebuffer(m_vkDevice, framebuffer, nullptr);
+		vkDestroyFramebuffer(m_vkDevice, framebuffer, hostAllocator(MemorySubsystem::Swapchain));
 	}
 
 	for (VkImageView swapchainImageView : m_vkSwapchainImageViews)
 	{
-		vkDestroyImageView(m_vkDevice, swapchainImageView, nullptr);
+		vkDestroyImageView(m_vkDevice, swapchainImageView, hostAllocator(MemorySubsystem::Swapchain));
+	}
+
+	for (size_t i = 0; i < m_vkOffscreenImageMemories.size(); ++i)
+	{
+		vkDestroyImage(m_vkDevice, m_vkSwapchainImages[i], hostAllocator(MemorySubsystem::Swapchain));
+		freeDeviceMemory(m_vkOffscreenImageMemories[i]);
+	}
+
+	vkDestroyDevice(m_vkDevice, hostAllocator(MemorySubsystem::Core));
+	vkDestroyInstance(m_vkInstance, hostAllocator(MemorySubsystem::Core));
+}
+
+void Engine::setSceneFog(bool enabled)
+{
+	if (m_settings.occlusionCulling)
+	{
+		m_pipelineState.specializationConstants = { enabled ? VK_TRUE : VK_FALSE };
+	}
+}
+
+void Engine::setHudVisible(bool visible)
+{
+	m_hudVisible = visible;
+}
+
+bool Engine::isHudVisible() const
+{
+	return m_hudVisible;
+}
+
+const OcclusionStats& Engine::getOcclusionStats() const
+{
+	return m_occlusionStats;
+}
+
+const ParticleStats& Engine::getParticleStats() const
+{
+	return m_particleStats;
+}
+
+const LightingStats& Engine::getLightingStats() const
+{
+	return m_lightingStats;
+}
+
+const RenderQueueStats& Engine::getRenderQueueStats() const
+{
+	return m_renderQueue.getStats();
+}
+
+void Engine::setPresentInterval(size_t window, uint32_t interval)
+{
+	if (window == 0)
+	{
+		throw std::runtime_error("The first window presents every frame.");
+	}
+
+	m_windows.at(window).stats.presentInterval = std::max(interval, 1u);
+}
+
+std::vector<WindowStats> Engine::getWindowStats() const
+{
+	std::vector<WindowStats> stats;
+
+	for (const EngineWindow& window : m_windows)
+	{
+		stats.push_back(window.stats);
+	}
+
+	return stats;
+}
+
+const FrameStats& Engine::getFrameStats() const
+{
+	return m_frameStats;
+}
+
+PipelineVariantStats Engine::getPipelineVariantStats() const
+{
+	return m_pipelineVariants->getStats();
+}
+
+const StartupStats& Engine::getStartupStats() const
+{
+	return m_startupStats;
+}
+
+FrameCaptureStats Engine::getFrameCaptureStats() const
+{
+	FrameCaptureStats stats = m_captureStats;
+	if (m_frameWriter)
+	{
+		stats.written = m_frameWriter->getWrittenCount();
+		stats.failed = m_frameWriter->getFailedCount();
+	}
+
+	return stats;
+}
+
+void Engine::addFrameStatsCallback(FrameStatsCallback callback)
+{
+	m_frameStatsCallbacks.push_back(callback);
+}
+
+const std::vector<CommandStreamResource>& Engine::getCreatedResources() const
+{
+	return m_createdResources;
+}
+
+MemoryStats Engine::getMemoryStats() const
+{
+	return m_memoryTracker->getStats();
+}
+
+void Engine::addMemoryBudgetCallback(MemoryTracker::BudgetCallback callback)
+{
+	m_memoryTracker->addBudgetCallback(callback);
+}
+
+void Engine::dumpMemoryStats(const std::string& fileName)
+{
+	m_memoryTracker->update(m_frameNumber);
+
+	std::ofstream file(fileName);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open memory stats file.");
 	}
 
-	vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
-	vkDestroyDevice(m_vkDevice, nullptr);
-	vkDestroyInstance(m_vkInstance, nullptr);
+	m_memoryTracker->writeJson(file);
 }
@@ -1,9 +1,54 @@
 #pragma once
 
 #include <vulkan.h>
+#include "CommandStream.h"
+#include "FrameWriter.h"
+#include "HudBatch.h"
+#include "MemoryTracker.h"
+#include "PipelineVariants.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "TaskGraph.h"
+#include "ThreadPool.h"
+#include "TimelineSemaphore.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+struct EngineSettings
+{
+	bool occlusionCulling = false;
+	uint32_t sceneInstanceCount = 16384;
+	bool sceneFog = false;
+	bool headless = false;
+	uint32_t width = 800;
+	uint32_t height = 600;
+	CaptureFormat captureFormat = CaptureFormat::None;
+	std::string capturePath = "capture";
+	uint32_t captureFrameRate = 60;
+	float memoryBudgetThreshold = 0.9f;
+	bool parallelInit = true;
+	bool particles = false;
+	uint32_t particleCount = 1048576;
+	bool asyncCompute = true;
+	bool hud = false;
+	std::string commandStreamPath;
+	bool dynamicResolution = false;
+	float targetFrameTimeMs = 16.7f;
+	float minRenderScale = 0.5f;
+	bool clusteredLighting = false;
+	uint32_t lightCount = 1024;
+	uint32_t queuedDraws = 0;
+	bool parallelSort = true;
+	uint32_t viewportPresentInterval = 1;
+};
+
 struct QueueFamilyIndices
 {
 	std::optional<uint32_t> graphics;
@@ -17,67 +62,469 @@ struct SwapChainSupportDetails
 	std::vector<VkPresentModeKHR> presentModes;
 };
 
+struct OcclusionStats
+{
+	uint32_t instanceCount;
+	uint32_t drawnEarly;
+	uint32_t drawnLate;
+	uint32_t occluded;
+	uint32_t frustumCulled;
+	double cullingGpuTimeMs;
+	double drawGpuTimeMs;
+	double savedGpuTimeMs;
+};
+
+struct ParticleStats
+{
+	uint32_t particleCount;
+	bool asyncCompute;
+	double simulateGpuTimeMs;
+	double sortGpuTimeMs;
+	double drawGpuTimeMs;
+	uint64_t measuredFrames;
+	double particlesPerSecond;
+};
+
+struct LightingStats
+{
+	uint32_t lightCount;
+	uint32_t clusterCount;
+	double binGpuTimeMs;
+	double shadeGpuTimeMs;
+	double averageClusterLights;
+	uint32_t maxClusterLights;
+	uint32_t overflowedClusters;
+};
+
+struct FrameStats
+{
+	uint64_t frameNumber;
+	double frameTimeMs;
+	double cpuTimeMs;
+	double gpuTimeMs;
+	double hudCpuTimeMs;
+	double hudGpuTimeMs;
+	uint32_t drawCount;
+	float renderScale;
+};
+
+struct StartupStats
+{
+	std::vector<TaskTiming> phases;
+	double initTimeMs;
+	double timeToFirstFrameMs;
+};
+
+struct WindowStats
+{
+	uint32_t presentInterval;
+	uint64_t presentedFrames;
+	uint64_t skippedFrames;
+	double acquireTimeMs;
+	double recordTimeMs;
+	double presentIntervalMs;
+	uint32_t swapchainRecreations;
+};
+
+// A window with its own surface, swapchain and frame semaphores. The first
+// window presents the engine's main render target; the others are viewports
+// with their own framebuffers and command buffers that draw the main pass.
+struct EngineWindow
+{
+	struct SDL_Window* sdlWindow;
+	VkSurfaceKHR surface;
+	VkSwapchainKHR swapchain;
+	VkExtent2D extent;
+	std::vector<VkImage> images;
+	std::vector<VkImageView> imageViews;
+	std::vector<VkFramebuffer> framebuffers;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkSemaphore> imageAvailableSemaphores;
+	std::vector<VkSemaphore> renderFinishedSemaphores;
+	std::vector<uint64_t> imageTimelineValues;
+	uint32_t imageIndex;
+	bool presenting;
+	bool outOfDate;
+	std::chrono::steady_clock::time_point lastPresent;
+	WindowStats stats;
+};
+
+struct CaptureSlot
+{
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	uint8_t* pixels;
+	uint64_t frameNumber;
+	std::atomic<bool> busy;
+};
+
 class Engine
 {
 private:
 	const int MAX_FRAMES_IN_FLIGHT;
+	const uint32_t OCCLUSION_TIMESTAMP_COUNT;
+	const uint32_t CAPTURE_RING_SIZE;
+	const uint32_t MEMORY_STATS_INTERVAL;
+	const uint32_t PARTICLE_TIMESTAMP_COUNT;
+	const uint32_t FRAME_TIMESTAMP_COUNT;
+	const uint32_t HUD_MAX_VERTICES;
+	const uint32_t HUD_HISTORY_SIZE;
+	const uint32_t LIGHTING_TIMESTAMP_COUNT;
+
+	EngineSettings m_settings;
+	std::unique_ptr<MemoryTracker> m_memoryTracker;
+	bool m_memoryBudgetSupported;
 
-	struct SDL_Window* m_sdlWindow;
+	std::vector<EngineWindow> m_windows;
 	VkInstance m_vkInstance;
 	VkPhysicalDevice m_vkPhysicalDevice;
 	VkDevice m_vkDevice;
 	VkQueue m_vkGraphicsQueue;
 	VkQueue m_vkPresentationQueue;
-	VkSurfaceKHR m_vkSurface;
-	VkSwapchainKHR m_vkSwapchain;
+	std::optional<uint32_t> m_computeQueueFamily;
+	std::vector<uint32_t> m_computeSharingFamilies;
+	VkQueue m_vkComputeQueue;
 	std::vector<VkImage> m_vkSwapchainImages;
 	std::vector<VkImageView> m_vkSwapchainImageViews;
+	std::vector<VkDeviceMemory> m_vkOffscreenImageMemories;
+	VkImageLayout m_vkPresentLayout;
 	VkFormat m_vkSwapchainImageFormat;
+	VkColorSpaceKHR m_vkSwapchainColorSpace;
 	VkExtent2D m_vkSwapchainExtent;
 	std::vector<const char*> m_deviceExtensions;
 	VkRenderPass m_vkRenderPass;
 	VkPipelineLayout m_vkPipelineLayout;
-	VkPipeline m_vkPipeline;
+	VkPipelineCache m_vkPipelineCache;
+	VkPipeline m_vkFallbackPipeline;
+	GraphicsPipelineState m_pipelineState;
+	std::unordered_map<std::string, std::vector<char>> m_shaderCode;
+	std::unique_ptr<ThreadPool> m_threadPool;
+	std::unique_ptr<PipelineVariants> m_pipelineVariants;
 	std::vector<VkFramebuffer> m_vkSwapchainFramebuffers;
 	VkCommandPool m_vkCommandPool;
 	std::vector<VkCommandBuffer> m_vkCommandBuffers;
-	std::vector<VkSemaphore> m_vkImageAvailableSemaphores;
-	std::vector<VkSemaphore> m_vkRenderFinishedSemaphores;
-	std::vector<VkFence> m_vkFences;
-	std::vector<VkFence> m_vkImagesInFlightFences;
+	std::unique_ptr<TimelineSemaphore> m_graphicsTimeline;
+	std::vector<uint64_t> m_frameTimelineValues;
+	std::vector<uint64_t> m_imageTimelineValues;
+	std::vector<uint32_t> m_frameImageIndices;
 	int m_currentFrame;
+	uint64_t m_frameNumber;
+
+	std::chrono::steady_clock::time_point m_initStart;
+	StartupStats m_startupStats;
+
+	std::unique_ptr<FrameWriter> m_frameWriter;
+	std::vector<std::unique_ptr<CaptureSlot>> m_captureSlots;
+	bool m_captureBgra;
+	FrameCaptureStats m_captureStats;
+
+	VkFormat m_vkDepthFormat;
+	VkImage m_vkDepthImage;
+	VkDeviceMemory m_vkDepthImageMemory;
+	VkImageView m_vkDepthImageView;
+	VkRenderPass m_vkLateRenderPass;
+	VkImage m_vkDepthPyramid;
+	VkDeviceMemory m_vkDepthPyramidMemory;
+	VkImageView m_vkDepthPyramidView;
+	std::vector<VkImageView> m_vkDepthPyramidMipViews;
+	VkExtent2D m_depthPyramidExtent;
+	uint32_t m_depthPyramidLevels;
+	VkSampler m_vkDepthPyramidSampler;
+	VkBuffer m_vkInstanceBuffer;
+	VkDeviceMemory m_vkInstanceBufferMemory;
+	VkBuffer m_vkDrawCommandBuffer;
+	VkDeviceMemory m_vkDrawCommandBufferMemory;
+	VkBuffer m_vkVisibilityBuffer;
+	VkDeviceMemory m_vkVisibilityBufferMemory;
+	std::vector<VkBuffer> m_vkOcclusionStatsBuffers;
+	std::vector<VkDeviceMemory> m_vkOcclusionStatsBufferMemories;
+	std::vector<void*> m_occlusionStatsMappings;
+	VkDescriptorPool m_vkOcclusionDescriptorPool;
+	VkDescriptorSetLayout m_vkSceneDescriptorSetLayout;
+	VkDescriptorSetLayout m_vkCullDescriptorSetLayout;
+	VkDescriptorSetLayout m_vkDepthPyramidDescriptorSetLayout;
+	VkDescriptorSet m_vkSceneDescriptorSet;
+	std::vector<VkDescriptorSet> m_vkCullDescriptorSets;
+	std::vector<VkDescriptorSet> m_vkDepthPyramidDescriptorSets;
+	VkPipelineLayout m_vkCullPipelineLayout;
+	VkPipelineLayout m_vkDepthPyramidPipelineLayout;
+	VkPipeline m_vkCullPipeline;
+	VkPipeline m_vkDepthPyramidPipeline;
+	VkQueryPool m_vkOcclusionQueryPool;
+	float m_timestampPeriod;
+	SceneCamera m_sceneCamera;
+	OcclusionStats m_occlusionStats;
+
+	std::vector<VkBuffer> m_vkParticleBuffers;
+	std::vector<VkDeviceMemory> m_vkParticleBufferMemories;
+	std::vector<VkBuffer> m_vkSortKeyBuffers;
+	std::vector<VkDeviceMemory> m_vkSortKeyBufferMemories;
+	std::vector<VkBuffer> m_vkSortValueBuffers;
+	std::vector<VkDeviceMemory> m_vkSortValueBufferMemories;
+	VkBuffer m_vkSortScratchKeyBuffer;
+	VkDeviceMemory m_vkSortScratchKeyBufferMemory;
+	VkBuffer m_vkSortScratchValueBuffer;
+	VkDeviceMemory m_vkSortScratchValueBufferMemory;
+	VkBuffer m_vkSortHistogramBuffer;
+	VkDeviceMemory m_vkSortHistogramBufferMemory;
+	uint32_t m_radixSortGroupCount;
+	VkDescriptorPool m_vkParticleDescriptorPool;
+	VkDescriptorSetLayout m_vkParticleSimulateDescriptorSetLayout;
+	VkDescriptorSetLayout m_vkRadixSortDescriptorSetLayout;
+	VkDescriptorSetLayout m_vkParticleDrawDescriptorSetLayout;
+	std::vector<VkDescriptorSet> m_vkParticleSimulateDescriptorSets;
+	std::vector<VkDescriptorSet> m_vkRadixSortDescriptorSets;
+	std::vector<VkDescriptorSet> m_vkParticleDrawDescriptorSets;
+	VkPipelineLayout m_vkParticleSimulatePipelineLayout;
+	VkPipelineLayout m_vkRadixSortPipelineLayout;
+	VkPipeline m_vkParticleSimulatePipeline;
+	VkPipeline m_vkRadixHistogramPipeline;
+	VkPipeline m_vkRadixScanPipeline;
+	VkPipeline m_vkRadixScatterPipeline;
+	VkCommandPool m_vkComputeCommandPool;
+	std::vector<VkCommandBuffer> m_vkComputeCommandBuffers;
+	std::unique_ptr<TimelineSemaphore> m_computeTimeline;
+	VkQueryPool m_vkParticleQueryPool;
+	SceneCamera m_particleCamera;
+	double m_particleComputeTotalMs;
+	ParticleStats m_particleStats;
+
+	bool m_hudVisible;
+	VkRenderPass m_vkHudRenderPass;
+	std::vector<VkFramebuffer> m_vkHudFramebuffers;
+	VkImage m_vkHudFontImage;
+	VkDeviceMemory m_vkHudFontImageMemory;
+	VkImageView m_vkHudFontImageView;
+	VkSampler m_vkHudFontSampler;
+	VkBuffer m_vkHudVertexBuffer;
+	VkDeviceMemory m_vkHudVertexBufferMemory;
+	HudVertex* m_hudVertices;
+	VkDescriptorPool m_vkHudDescriptorPool;
+	VkDescriptorSetLayout m_vkHudDescriptorSetLayout;
+	VkDescriptorSet m_vkHudDescriptorSet;
+	VkPipelineLayout m_vkHudPipelineLayout;
+	VkPipeline m_vkHudPipeline;
+	VkQueryPool m_vkFrameQueryPool;
+	std::chrono::steady_clock::time_point m_lastFrameStart;
+	std::vector<float> m_hudFrameTimes;
+	MemoryStats m_hudMemoryStats;
+	std::vector<FrameStats> m_pendingFrameStats;
+	FrameStats m_frameStats;
+	std::vector<std::function<void(const FrameStats&)>> m_frameStatsCallbacks;
+
+	std::unique_ptr<CommandStreamWriter> m_commandStreamWriter;
+	const CommandStreamReader* m_replaySource;
+	std::mutex m_resourceMutex;
+	std::vector<CommandStreamResource> m_createdResources;
+
+	VkRenderPass m_vkScaledRenderPass;
+	VkImage m_vkScaledImage;
+	VkDeviceMemory m_vkScaledImageMemory;
+	VkImageView m_vkScaledImageView;
+	VkFramebuffer m_vkScaledFramebuffer;
+	float m_renderScale;
+	float m_renderScaleEstimate;
+
+	VkBuffer m_vkLightBuffer;
+	VkDeviceMemory m_vkLightBufferMemory;
+	VkDeviceSize m_lightSliceSize;
+	void* m_lightMapping;
+	std::vector<SceneLight> m_sceneLights;
+	VkBuffer m_vkClusterBuffer;
+	VkDeviceMemory m_vkClusterBufferMemory;
+	std::vector<VkBuffer> m_vkLightingUniformBuffers;
+	std::vector<VkDeviceMemory> m_vkLightingUniformBufferMemories;
+	std::vector<void*> m_lightingUniformMappings;
+	std::vector<VkBuffer> m_vkLightingStatsBuffers;
+	std::vector<VkDeviceMemory> m_vkLightingStatsBufferMemories;
+	std::vector<void*> m_lightingStatsMappings;
+	VkDescriptorPool m_vkLightingDescriptorPool;
+	VkDescriptorSetLayout m_vkLightingDescriptorSetLayout;
+	std::vector<VkDescriptorSet> m_vkLightingDescriptorSets;
+	VkPipelineLayout m_vkLightBinningPipelineLayout;
+	VkPipeline m_vkLightBinningPipeline;
+	VkQueryPool m_vkLightingQueryPool;
+	SceneCamera m_lightingCamera;
+	LightingStats m_lightingStats;
+
+	std::vector<SceneDraw> m_sceneDraws;
+	RenderQueue m_renderQueue;
+	VkBuffer m_vkQueuedDrawMeshBuffer;
+	VkDeviceMemory m_vkQueuedDrawMeshBufferMemory;
+	std::vector<VkDeviceSize> m_queuedDrawMeshOffsets;
+	std::vector<uint32_t> m_queuedDrawMeshVertexCounts;
+	VkBuffer m_vkQueuedDrawMaterialBuffer;
+	VkDeviceMemory m_vkQueuedDrawMaterialBufferMemory;
+	VkDeviceSize m_queuedDrawMaterialStride;
+	VkDescriptorPool m_vkQueuedDrawDescriptorPool;
+	VkDescriptorSetLayout m_vkQueuedDrawDescriptorSetLayout;
+	std::vector<VkDescriptorSet> m_vkQueuedDrawMaterialSets;
+	std::vector<VkPipeline> m_vkQueuedDrawPipelines;
 
 	void initVkInstance();
-	void createVkSurface();
+	void createVkSurfaces();
 	void pickPhysicalDevice();
 	void createDevice();
-	void createSwapChain();
-	void createSwapChainImageViews();
+	void chooseSwapchainFormat();
+	void createSwapChain(EngineWindow& window);
+	void createOffscreenImages();
+	void createSwapChainImageViews(const std::vector<VkImage>& images, std::vector<VkImageView>& imageViews);
 	void createRenderPass();
+	void choosePipelineState();
+	void readShaderFiles();
 	void createGraphicsPipeline();
 	void createFramebuffers();
 	void createCommandPool();
 	void createCommandBuffers();
-	void createSemaphores();
-	void createFences();
+	void recordCommandBuffer(uint32_t imageIndex, VkPipeline pipeline, int captureSlot, const HudReadout& hud);
+	void createSyncObjects();
+
+	void chooseDepthFormat();
+	void createDepthResources();
+	void createOcclusionRenderPasses();
+	void createOcclusionResources();
+	void createDepthPyramid();
+	void createOcclusionDescriptorSetLayouts();
+	void createOcclusionDescriptors();
+	void createOcclusionPipelines();
+	void recordOcclusionCommands(VkCommandBuffer commandBuffer, size_t imageIndex, VkPipeline pipeline);
+	void recordDepthPyramidBuild(VkCommandBuffer commandBuffer);
+	void collectOcclusionStats(uint32_t frameSlot);
+	void destroyOcclusionResources();
+
+	void createParticleDescriptorSetLayouts();
+	void createParticleResources();
+	void createParticleDescriptors();
+	void createParticlePipelines();
+	void recordParticleCompute(VkCommandBuffer commandBuffer);
+	void recordParticleDraw(VkCommandBuffer commandBuffer, VkPipeline pipeline);
+	uint64_t submitParticleCompute();
+	void collectParticleStats(uint32_t frameSlot);
+	void destroyParticleResources();
 
+	void createHudRenderPass();
+	void createHudFramebuffers();
+	void createHudDescriptorSetLayout();
+	void createHudResources();
+	void createHudFontAtlas();
+	void createHudPipeline();
+	double measureFrameTime();
+	void writeFrameTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t query);
+	HudReadout readHud();
+	void buildHudOverlay(HudBatch& batch, const HudReadout& hud);
+	void recordHud(VkCommandBuffer commandBuffer, uint32_t imageIndex, const HudReadout& hud);
+	void collectFrameStats(uint32_t frameSlot);
+	void destroyHudResources();
+
+	void createCommandStream();
+	void recordResource(const CommandStreamResource& resource);
+	void streamUpload(CommandStreamUpload upload, void* data, size_t size);
+	void compileReplayPipelines();
+	void renderFrame(const CommandStreamFrame* replayFrame);
+
+	void createScaledRenderPass();
+	void createScaledRenderTarget();
+	VkExtent2D getRenderExtent() const;
+	void updateRenderScale();
+	void recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent);
+	void destroyScaledRenderTarget();
+
+	void createLightingDescriptorSetLayout();
+	void createLightingResources();
+	void createLightingDescriptors();
+	void createLightingPipelines();
+	void recordLightBinning(VkCommandBuffer commandBuffer);
+	void recordLitDraw(VkCommandBuffer commandBuffer, VkPipeline pipeline);
+	void collectLightingStats(uint32_t frameSlot);
+	void destroyLightingResources();
+
+	void createQueuedDrawDescriptorSetLayout();
+	void createQueuedDrawResources();
+	void createQueuedDrawDescriptors();
+	void createQueuedDrawPipelines();
+	void sortQueuedDraws();
+	void recordQueuedDraws(VkCommandBuffer commandBuffer);
+	void destroyQueuedDrawResources();
+
+	void createViewportTargets();
+	void createWindowTargets(EngineWindow& window);
+	void destroyWindowTargets(EngineWindow& window);
+	bool recreateViewportSwapchain(EngineWindow& window);
+	bool acquireWindowImage(EngineWindow& window);
+	std::vector<VkCommandBuffer> recordViewports(VkPipeline pipeline);
+	void recordViewportCommands(EngineWindow& window, VkPipeline pipeline);
+	void presentWindows();
+	void destroyWindows();
+
+	void createCaptureResources();
+	int acquireCaptureSlot();
+	void recordCaptureCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex, int captureSlot);
+	void submitCapturedFrame(int captureSlot);
+	void destroyCaptureResources();
+
+	VkPipeline buildGraphicsPipeline(const GraphicsPipelineState& state, VkPipelineLayout pipelineLayout, VkRenderPass renderPass);
+	VkPipeline createComputePipeline(const char* fileName, VkPipelineLayout pipelineLayout);
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+		VkBuffer& buffer, VkDeviceMemory& memory, MemorySubsystem subsystem);
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format,
+		VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, MemorySubsystem subsystem);
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask,
+		uint32_t baseMipLevel, uint32_t levelCount);
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+	void freeDeviceMemory(VkDeviceMemory memory);
+	const VkAllocationCallbacks* hostAllocator(MemorySubsystem subsystem) const;
+	VkCommandBuffer beginSingleTimeCommands();
+	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+
+	std::vector<char> readShaderFile(const char* fileName);
 	VkShaderModule loadShader(const char* fileName);
 	QueueFamilyIndices findQueueFamilyIndices(VkPhysicalDevice physicalDevice);
-	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice);
+	std::optional<uint32_t> findAsyncComputeQueueFamily(VkPhysicalDevice physicalDevice);
+	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats);
 	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& presentModes);
-	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
+	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, struct SDL_Window* sdlWindow);
 
+	bool checkInstanceExtensionSupport(const char* extensionName);
 	bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
+	bool checkMemoryBudgetSupport(VkPhysicalDevice physicalDevice);
 	bool checkSwapchainSupport(VkPhysicalDevice physicalDevice);
 	bool checkQueueFamiliesSupport(VkPhysicalDevice physicalDevice);
+	bool checkTimelineSemaphoreSupport(VkPhysicalDevice physicalDevice);
 	
 public:
-	Engine();
+	typedef std::function<void(const FrameStats&)> FrameStatsCallback;
+
+	Engine(const EngineSettings& settings = EngineSettings());
 
 	void init(struct SDL_Window* sdlWindow);
+	void init(const std::vector<struct SDL_Window*>& sdlWindows);
 	void update();
 	void render();
 	void cleanUp();
+
+	void setReplaySource(const CommandStreamReader* reader);
+	void replayFrame(const CommandStreamFrame& frame);
+
+	void setSceneFog(bool enabled);
+	void setHudVisible(bool visible);
+	bool isHudVisible() const;
+
+	const OcclusionStats& getOcclusionStats() const;
+	const ParticleStats& getParticleStats() const;
+	const LightingStats& getLightingStats() const;
+	const RenderQueueStats& getRenderQueueStats() const;
+	void setPresentInterval(size_t window, uint32_t interval);
+	std::vector<WindowStats> getWindowStats() const;
+	const FrameStats& getFrameStats() const;
+	PipelineVariantStats getPipelineVariantStats() const;
+	const StartupStats& getStartupStats() const;
+	FrameCaptureStats getFrameCaptureStats() const;
+	void addFrameStatsCallback(FrameStatsCallback callback);
+	const std::vector<CommandStreamResource>& getCreatedResources() const;
+
+	MemoryStats getMemoryStats() const;
+	void addMemoryBudgetCallback(MemoryTracker::BudgetCallback callback);
+	void dumpMemoryStats(const std::string& fileName);
 };
 
@@ -0,0 +1,167 @@
+#include "Engine.h"
+#include <stdexcept>
+
+void Engine::createCaptureResources()
+{
+	switch (m_vkSwapchainImageFormat)
+	{
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		m_captureBgra = true;
+		break;
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		m_captureBgra = false;
+		break;
+	default:
+		throw std::runtime_error("Swap chain format cannot be captured.");
+	}
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(m_vkPhysicalDevice, &memoryProperties);
+
+	VkMemoryPropertyFlags readbackProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	bool cachedAvailable = false;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	{
+		if ((memoryProperties.memoryTypes[i].propertyFlags & readbackProperties) == readbackProperties)
+		{
+			cachedAvailable = true;
+		}
+	}
+
+	if (!cachedAvailable)
+	{
+		readbackProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	VkDeviceSize frameSize = static_cast<VkDeviceSize>(m_vkSwapchainExtent.width) * m_vkSwapchainExtent.height * 4;
+
+	m_captureSlots.resize(CAPTURE_RING_SIZE);
+
+	for (std::unique_ptr<CaptureSlot>& slot : m_captureSlots)
+	{
+		slot.reset(new CaptureSlot());
+		slot->frameNumber = 0;
+		slot->busy = false;
+
+		createBuffer(frameSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, readbackProperties, slot->buffer, slot->memory,
+			MemorySubsystem::Capture);
+
+		void* data;
+		vkMapMemory(m_vkDevice, slot->memory, 0, frameSize, 0, &data);
+		slot->pixels = static_cast<uint8_t*>(data);
+	}
+
+	m_captureStats = {};
+	m_frameWriter.reset(new FrameWriter(m_settings.captureFormat, m_settings.capturePath,
+		m_vkSwapchainExtent.width, m_vkSwapchainExtent.height, m_settings.captureFrameRate));
+}
+
+int Engine::acquireCaptureSlot()
+{
+	for (size_t i = 0; i < m_captureSlots.size(); ++i)
+	{
+		if (!m_captureSlots[i]->busy)
+		{
+			m_captureSlots[i]->busy = true;
+			m_captureSlots[i]->frameNumber = m_frameNumber;
+			++m_captureStats.captured;
+
+			return static_cast<int>(i);
+		}
+	}
+
+	++m_captureStats.dropped;
+
+	return -1;
+}
+
+void Engine::recordCaptureCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex, int captureSlot)
+{
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = m_vkPresentLayout;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = m_vkSwapchainImages[imageIndex];
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { m_vkSwapchainExtent.width, m_vkSwapchainExtent.height, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, m_vkSwapchainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		m_captureSlots[captureSlot]->buffer, 1, &region);
+
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = 0;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = m_vkPresentLayout;
+
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = m_captureSlots[captureSlot]->buffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+}
+
+void Engine::submitCapturedFrame(int captureSlot)
+{
+	CaptureSlot* slot = m_captureSlots[captureSlot].get();
+
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = slot->memory;
+	range.offset = 0;
+	range.size = VK_WHOLE_SIZE;
+	vkInvalidateMappedMemoryRanges(m_vkDevice, 1, &range);
+
+	m_frameWriter->submit(slot->pixels, m_captureBgra, slot->frameNumber, [slot]()
+	{
+		slot->busy = false;
+	});
+}
+
+void Engine::destroyCaptureResources()
+{
+	m_frameWriter->flush();
+	m_captureStats.written = m_frameWriter->getWrittenCount();
+	m_captureStats.failed = m_frameWriter->getFailedCount();
+	m_frameWriter.reset();
+
+	for (std::unique_ptr<CaptureSlot>& slot : m_captureSlots)
+	{
+		vkUnmapMemory(m_vkDevice, slot->memory);
+		vkDestroyBuffer(m_vkDevice, slot->buffer, hostAllocator(MemorySubsystem::Capture));
+		freeDeviceMemory(slot->memory);
+	}
+
+	m_captureSlots.clear();
+}
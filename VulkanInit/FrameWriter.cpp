@@ -0,0 +1,267 @@
+#include "FrameWriter.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	const size_t MAX_STORED_BLOCK_SIZE = 65535;
+
+	std::array<uint32_t, 256> makeCrcTable()
+	{
+		std::array<uint32_t, 256> table;
+
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t value = i;
+
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			}
+
+			table[i] = value;
+		}
+
+		return table;
+	}
+
+	uint32_t crc32(const uint8_t* data, size_t size)
+	{
+		static const std::array<uint32_t, 256> table = makeCrcTable();
+		uint32_t crc = 0xFFFFFFFFu;
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+
+		return ~crc;
+	}
+
+	void appendBigEndian(std::vector<uint8_t>& output, uint32_t value)
+	{
+		output.push_back(static_cast<uint8_t>(value >> 24));
+		output.push_back(static_cast<uint8_t>(value >> 16));
+		output.push_back(static_cast<uint8_t>(value >> 8));
+		output.push_back(static_cast<uint8_t>(value));
+	}
+
+	void appendChunk(std::vector<uint8_t>& output, const char* type, const std::vector<uint8_t>& data)
+	{
+		appendBigEndian(output, static_cast<uint32_t>(data.size()));
+
+		size_t typeOffset = output.size();
+		output.insert(output.end(), type, type + 4);
+		output.insert(output.end(), data.begin(), data.end());
+
+		appendBigEndian(output, crc32(output.data() + typeOffset, data.size() + 4));
+	}
+
+	// Wraps the raw scanlines in a zlib stream made of stored deflate blocks.
+	// Skipping compression keeps the encode cost flat and avoids a zlib dependency.
+	std::vector<uint8_t> storeZlib(const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> output;
+		output.reserve(data.size() + data.size() / MAX_STORED_BLOCK_SIZE * 5 + 16);
+		output.push_back(0x78);
+		output.push_back(0x01);
+
+		size_t offset = 0;
+
+		do
+		{
+			size_t blockSize = std::min(MAX_STORED_BLOCK_SIZE, data.size() - offset);
+			bool lastBlock = offset + blockSize == data.size();
+
+			output.push_back(lastBlock ? 1 : 0);
+			output.push_back(static_cast<uint8_t>(blockSize));
+			output.push_back(static_cast<uint8_t>(blockSize >> 8));
+			output.push_back(static_cast<uint8_t>(~blockSize));
+			output.push_back(static_cast<uint8_t>(~blockSize >> 8));
+			output.insert(output.end(), data.begin() + offset, data.begin() + offset + blockSize);
+
+			offset += blockSize;
+		} while (offset < data.size());
+
+		uint32_t a = 1;
+		uint32_t b = 0;
+
+		for (uint8_t byte : data)
+		{
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+
+		appendBigEndian(output, (b << 16) | a);
+
+		return output;
+	}
+}
+
+FrameWriter::FrameWriter(CaptureFormat format, const std::string& path, uint32_t width, uint32_t height,
+	uint32_t frameRate)
+	: m_format(format),
+	m_path(path),
+	m_width(width),
+	m_height(height),
+	m_written(0),
+	m_failed(0)
+{
+	if (m_format == CaptureFormat::Png)
+	{
+		std::filesystem::create_directories(m_path);
+		m_threadPool.reset(new ThreadPool(ThreadPool::defaultWorkerCount()));
+	}
+	else if (m_format == CaptureFormat::Y4m)
+	{
+		m_y4mStream.open(m_path, std::ios::binary);
+
+		if (!m_y4mStream.is_open())
+		{
+			throw std::runtime_error("Failed to open capture file.");
+		}
+
+		m_y4mStream << "YUV4MPEG2 W" << m_width << " H" << m_height
+			<< " F" << frameRate << ":1 Ip A1:1 C444\n";
+
+		m_threadPool.reset(new ThreadPool(1));
+	}
+}
+
+FrameWriter::~FrameWriter()
+{
+	flush();
+}
+
+void FrameWriter::submit(const uint8_t* pixels, bool bgra, uint64_t frameNumber, std::function<void()> onWritten)
+{
+	m_threadPool->submit([this, pixels, bgra, frameNumber, onWritten]()
+	{
+		try
+		{
+			if (m_format == CaptureFormat::Png)
+			{
+				writePng(pixels, bgra, frameNumber);
+			}
+			else
+			{
+				writeY4m(pixels, bgra);
+			}
+
+			++m_written;
+		}
+		catch (const std::exception&)
+		{
+			++m_failed;
+		}
+
+		onWritten();
+	});
+}
+
+void FrameWriter::flush()
+{
+	if (m_threadPool)
+	{
+		m_threadPool->waitIdle();
+	}
+
+	if (m_y4mStream.is_open())
+	{
+		m_y4mStream.flush();
+	}
+}
+
+uint64_t FrameWriter::getWrittenCount() const
+{
+	return m_written;
+}
+
+uint64_t FrameWriter::getFailedCount() const
+{
+	return m_failed;
+}
+
+void FrameWriter::writePng(const uint8_t* pixels, bool bgra, uint64_t frameNumber)
+{
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((m_width * 3 + 1) * m_height);
+
+	for (uint32_t y = 0; y < m_height; ++y)
+	{
+		const uint8_t* row = pixels + static_cast<size_t>(y) * m_width * 4;
+		scanlines.push_back(0);
+
+		for (uint32_t x = 0; x < m_width; ++x)
+		{
+			const uint8_t* pixel = row + x * 4;
+			scanlines.push_back(bgra ? pixel[2] : pixel[0]);
+			scanlines.push_back(pixel[1]);
+			scanlines.push_back(bgra ? pixel[0] : pixel[2]);
+		}
+	}
+
+	std::vector<uint8_t> header;
+	appendBigEndian(header, m_width);
+	appendBigEndian(header, m_height);
+	header.push_back(8);
+	header.push_back(2);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<uint8_t> png(signature, signature + sizeof(signature));
+	appendChunk(png, "IHDR", header);
+	appendChunk(png, "IDAT", storeZlib(scanlines));
+	appendChunk(png, "IEND", std::vector<uint8_t>());
+
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "frame_%06llu.png", static_cast<unsigned long long>(frameNumber));
+
+	std::ofstream file((std::filesystem::path(m_path) / fileName).string(), std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open capture file.");
+	}
+
+	file.write(reinterpret_cast<const char*>(png.data()), png.size());
+	if (!file.good())
+	{
+		throw std::runtime_error("Failed to write capture file.");
+	}
+}
+
+void FrameWriter::writeY4m(const uint8_t* pixels, bool bgra)
+{
+	size_t planeSize = static_cast<size_t>(m_width) * m_height;
+	std::vector<uint8_t> planes(planeSize * 3);
+
+	for (size_t i = 0; i < planeSize; ++i)
+	{
+		const uint8_t* pixel = pixels + i * 4;
+		float r = bgra ? pixel[2] : pixel[0];
+		float g = pixel[1];
+		float b = bgra ? pixel[0] : pixel[2];
+
+		float luma = 0.299f * r + 0.587f * g + 0.114f * b;
+		float cb = 128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b;
+		float cr = 128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b;
+
+		planes[i] = static_cast<uint8_t>(std::min(std::max(luma + 0.5f, 0.0f), 255.0f));
+		planes[planeSize + i] = static_cast<uint8_t>(std::min(std::max(cb + 0.5f, 0.0f), 255.0f));
+		planes[planeSize * 2 + i] = static_cast<uint8_t>(std::min(std::max(cr + 0.5f, 0.0f), 255.0f));
+	}
+
+	m_y4mStream << "FRAME\n";
+	m_y4mStream.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+
+	if (!m_y4mStream.good())
+	{
+		throw std::runtime_error("Failed to write capture file.");
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+
+enum class CaptureFormat
+{
+	None,
+	Png,
+	Y4m
+};
+
+struct FrameCaptureStats
+{
+	uint64_t captured;
+	uint64_t dropped;
+	uint64_t written;
+	uint64_t failed;
+};
+
+// Encodes captured frames on worker threads. PNG frames are independent files
+// and are written in parallel; a Y4M stream needs frames in order, so it gets
+// a single worker.
+class FrameWriter
+{
+private:
+	CaptureFormat m_format;
+	std::string m_path;
+	uint32_t m_width;
+	uint32_t m_height;
+	std::ofstream m_y4mStream;
+	std::atomic<uint64_t> m_written;
+	std::atomic<uint64_t> m_failed;
+	std::unique_ptr<ThreadPool> m_threadPool;
+
+	void writePng(const uint8_t* pixels, bool bgra, uint64_t frameNumber);
+	void writeY4m(const uint8_t* pixels, bool bgra);
+
+public:
+	FrameWriter(CaptureFormat format, const std::string& path, uint32_t width, uint32_t height, uint32_t frameRate);
+	~FrameWriter();
+
+	void submit(const uint8_t* pixels, bool bgra, uint64_t frameNumber, std::function<void()> onWritten);
+	void flush();
+	uint64_t getWrittenCount() const;
+	uint64_t getFailedCount() const;
+};
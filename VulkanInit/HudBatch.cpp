@@ -0,0 +1,194 @@
+#include "HudBatch.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace
+{
+	struct Glyph
+	{
+		char character;
+		const char* rows[HudBatch::GLYPH_HEIGHT];
+	};
+
+	const Glyph GLYPHS[] = {
+		{ '0', { "###", "#.#", "#.#", "#.#", "###" } },
+		{ '1', { ".#.", "##.", ".#.", ".#.", "###" } },
+		{ '2', { "###", "..#", "###", "#..", "###" } },
+		{ '3', { "###", "..#", ".##", "..#", "###" } },
+		{ '4', { "#.#", "#.#", "###", "..#", "..#" } },
+		{ '5', { "###", "#..", "###", "..#", "###" } },
+		{ '6', { "###", "#..", "###", "#.#", "###" } },
+		{ '7', { "###", "..#", "..#", ".#.", ".#." } },
+		{ '8', { "###", "#.#", "###", "#.#", "###" } },
+		{ '9', { "###", "#.#", "###", "..#", "###" } },
+		{ 'A', { ".#.", "#.#", "###", "#.#", "#.#" } },
+		{ 'B', { "##.", "#.#", "##.", "#.#", "##." } },
+		{ 'C', { ".##", "#..", "#..", "#..", ".##" } },
+		{ 'D', { "##.", "#.#", "#.#", "#.#", "##." } },
+		{ 'E', { "###", "#..", "##.", "#..", "###" } },
+		{ 'F', { "###", "#..", "##.", "#..", "#.." } },
+		{ 'G', { ".##", "#..", "#.#", "#.#", ".##" } },
+		{ 'H', { "#.#", "#.#", "###", "#.#", "#.#" } },
+		{ 'I', { "###", ".#.", ".#.", ".#.", "###" } },
+		{ 'J', { "..#", "..#", "..#", "#.#", ".#." } },
+		{ 'K', { "#.#", "#.#", "##.", "#.#", "#.#" } },
+		{ 'L', { "#..", "#..", "#..", "#..", "###" } },
+		{ 'M', { "#.#", "###", "###", "#.#", "#.#" } },
+		{ 'N', { "##.", "#.#", "#.#", "#.#", "#.#" } },
+		{ 'O', { ".#.", "#.#", "#.#", "#.#", ".#." } },
+		{ 'P', { "##.", "#.#", "##.", "#..", "#.." } },
+		{ 'Q', { ".#.", "#.#", "#.#", "##.", ".##" } },
+		{ 'R', { "##.", "#.#", "##.", "#.#", "#.#" } },
+		{ 'S', { ".##", "#..", ".#.", "..#", "##." } },
+		{ 'T', { "###", ".#.", ".#.", ".#.", ".#." } },
+		{ 'U', { "#.#", "#.#", "#.#", "#.#", "###" } },
+		{ 'V', { "#.#", "#.#", "#.#", "#.#", ".#." } },
+		{ 'W', { "#.#", "#.#", "###", "###", "#.#" } },
+		{ 'X', { "#.#", "#.#", ".#.", "#.#", "#.#" } },
+		{ 'Y', { "#.#", "#.#", ".#.", ".#.", ".#." } },
+		{ 'Z', { "###", "..#", ".#.", "#..", "###" } },
+		{ '.', { "...", "...", "...", "...", ".#." } },
+		{ ':', { "...", ".#.", "...", ".#.", "..." } },
+		{ '/', { "..#", "..#", ".#.", "#..", "#.." } },
+		{ '%', { "#.#", "..#", ".#.", "#..", "#.#" } },
+		{ '-', { "...", "...", "###", "...", "..." } },
+		{ '(', { ".#.", "#..", "#..", "#..", ".#." } },
+		{ ')', { ".#.", "..#", "..#", "..#", ".#." } },
+		{ '\0', { "###", "###", "###", "###", "###" } }
+	};
+
+	const uint32_t GLYPH_COUNT = sizeof(GLYPHS) / sizeof(GLYPHS[0]);
+	const uint32_t SOLID_GLYPH = GLYPH_COUNT - 1;
+	const uint32_t GLYPH_STRIDE = HudBatch::GLYPH_WIDTH + 1;
+	const uint32_t ATLAS_WIDTH = GLYPH_COUNT * GLYPH_STRIDE;
+	const uint8_t MISSING_GLYPH = 0xff;
+
+	const std::array<uint8_t, 128>& glyphTable()
+	{
+		static const std::array<uint8_t, 128> table = []()
+		{
+			std::array<uint8_t, 128> glyphs;
+			glyphs.fill(MISSING_GLYPH);
+
+			for (uint32_t i = 0; i < SOLID_GLYPH; ++i)
+			{
+				glyphs[static_cast<uint8_t>(GLYPHS[i].character)] = static_cast<uint8_t>(i);
+			}
+
+			return glyphs;
+		}();
+
+		return table;
+	}
+
+	uint32_t packUv(float u, float v)
+	{
+		uint32_t x = static_cast<uint32_t>(std::clamp(u, 0.0f, 1.0f) * 65535.0f + 0.5f);
+		uint32_t y = static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+		return x | (y << 16);
+	}
+}
+
+HudFontAtlas HudBatch::buildFontAtlas()
+{
+	HudFontAtlas atlas;
+	atlas.width = ATLAS_WIDTH;
+	atlas.height = GLYPH_HEIGHT;
+	atlas.pixels.assign(atlas.width * atlas.height, 0);
+
+	for (uint32_t glyph = 0; glyph < GLYPH_COUNT; ++glyph)
+	{
+		for (uint32_t row = 0; row < GLYPH_HEIGHT; ++row)
+		{
+			for (uint32_t column = 0; column < GLYPH_WIDTH; ++column)
+			{
+				if (GLYPHS[glyph].rows[row][column] == '#')
+				{
+					atlas.pixels[row * atlas.width + glyph * GLYPH_STRIDE + column] = 0xff;
+				}
+			}
+		}
+	}
+
+	return atlas;
+}
+
+uint32_t HudBatch::packColor(float r, float g, float b, float a)
+{
+	auto channel = [](float value)
+	{
+		return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	};
+
+	return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (channel(a) << 24);
+}
+
+HudBatch::HudBatch(HudVertex* vertices, uint32_t capacity, uint32_t screenWidth, uint32_t screenHeight)
+	: m_vertices(vertices),
+	m_capacity(capacity),
+	m_count(0),
+	m_pixelToClipX(2.0f / static_cast<float>(screenWidth)),
+	m_pixelToClipY(2.0f / static_cast<float>(screenHeight))
+{
+}
+
+void HudBatch::addQuad(float x, float y, float width, float height, uint32_t uvMin, uint32_t uvMax, uint32_t color)
+{
+	if (m_count + 6 > m_capacity)
+	{
+		return;
+	}
+
+	float left = x * m_pixelToClipX - 1.0f;
+	float top = y * m_pixelToClipY - 1.0f;
+	float right = (x + width) * m_pixelToClipX - 1.0f;
+	float bottom = (y + height) * m_pixelToClipY - 1.0f;
+
+	uint32_t uvTopRight = (uvMax & 0xffff) | (uvMin & 0xffff0000);
+	uint32_t uvBottomLeft = (uvMin & 0xffff) | (uvMax & 0xffff0000);
+
+	HudVertex* vertex = m_vertices + m_count;
+	vertex[0] = { left, top, uvMin, color };
+	vertex[1] = { right, top, uvTopRight, color };
+	vertex[2] = { right, bottom, uvMax, color };
+	vertex[3] = { left, top, uvMin, color };
+	vertex[4] = { right, bottom, uvMax, color };
+	vertex[5] = { left, bottom, uvBottomLeft, color };
+
+	m_count += 6;
+}
+
+void HudBatch::addRect(float x, float y, float width, float height, uint32_t color)
+{
+	// Every corner samples the centre of the solid glyph, so the quad is flat.
+	uint32_t uv = packUv((SOLID_GLYPH * GLYPH_STRIDE + GLYPH_WIDTH * 0.5f) / ATLAS_WIDTH, 0.5f);
+	addQuad(x, y, width, height, uv, uv, color);
+}
+
+float HudBatch::addText(float x, float y, float scale, uint32_t color, const char* text)
+{
+	const std::array<uint8_t, 128>& glyphs = glyphTable();
+
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		uint8_t character = static_cast<uint8_t>(std::toupper(static_cast<unsigned char>(*c)));
+		uint8_t glyph = character < glyphs.size() ? glyphs[character] : MISSING_GLYPH;
+
+		if (glyph != MISSING_GLYPH)
+		{
+			float u = static_cast<float>(glyph * GLYPH_STRIDE);
+			addQuad(x, y, GLYPH_WIDTH * scale, GLYPH_HEIGHT * scale,
+				packUv(u / ATLAS_WIDTH, 0.0f), packUv((u + GLYPH_WIDTH) / ATLAS_WIDTH, 1.0f), color);
+		}
+
+		x += GLYPH_STRIDE * scale;
+	}
+
+	return x;
+}
+
+uint32_t HudBatch::getVertexCount() const
+{
+	return m_count;
+}
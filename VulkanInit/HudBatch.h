@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct HudVertex
+{
+	float x;
+	float y;
+	uint32_t uv;
+	uint32_t color;
+};
+
+struct HudFontAtlas
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> pixels;
+};
+
+// Appends HUD text and rectangles as textured quads into a caller-owned vertex
+// range, usually a slice of a persistently mapped ring buffer. Every quad
+// samples the same single-channel font atlas; rectangles sample its solid
+// glyph, so text, panels and graphs all go out in one draw.
+class HudBatch
+{
+private:
+	HudVertex* m_vertices;
+	uint32_t m_capacity;
+	uint32_t m_count;
+	float m_pixelToClipX;
+	float m_pixelToClipY;
+
+	void addQuad(float x, float y, float width, float height, uint32_t uvMin, uint32_t uvMax, uint32_t color);
+
+public:
+	static const uint32_t GLYPH_WIDTH = 3;
+	static const uint32_t GLYPH_HEIGHT = 5;
+
+	static HudFontAtlas buildFontAtlas();
+	static uint32_t packColor(float r, float g, float b, float a);
+
+	HudBatch(HudVertex* vertices, uint32_t capacity, uint32_t screenWidth, uint32_t screenHeight);
+
+	void addRect(float x, float y, float width, float height, uint32_t color);
+	float addText(float x, float y, float scale, uint32_t color, const char* text);
+
+	uint32_t getVertexCount() const;
+};
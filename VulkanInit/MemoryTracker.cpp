@@ -0,0 +1,362 @@
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	struct AllocationHeader
+	{
+		void* block;
+		size_t size;
+		MemorySubsystem subsystem;
+	};
+
+	AllocationHeader readHeader(void* memory)
+	{
+		AllocationHeader header;
+		std::memcpy(&header, static_cast<char*>(memory) - sizeof(AllocationHeader), sizeof(AllocationHeader));
+
+		return header;
+	}
+}
+
+const char* memorySubsystemName(MemorySubsystem subsystem)
+{
+	switch (subsystem)
+	{
+	case MemorySubsystem::Core:
+		return "core";
+	case MemorySubsystem::Swapchain:
+		return "swapchain";
+	case MemorySubsystem::RenderTargets:
+		return "renderTargets";
+	case MemorySubsystem::Buffers:
+		return "buffers";
+	case MemorySubsystem::Pipelines:
+		return "pipelines";
+	case MemorySubsystem::Descriptors:
+		return "descriptors";
+	case MemorySubsystem::Commands:
+		return "commands";
+	case MemorySubsystem::Sync:
+		return "sync";
+	case MemorySubsystem::Capture:
+		return "capture";
+	case MemorySubsystem::Hud:
+		return "hud";
+	default:
+		return "unknown";
+	}
+}
+
+MemoryTracker::MemoryTracker(float budgetThreshold)
+	: m_budgetThreshold(budgetThreshold),
+	m_vkPhysicalDevice(VK_NULL_HANDLE),
+	m_vkMemoryProperties(),
+	m_getMemoryProperties2(nullptr),
+	m_stats()
+{
+	for (size_t i = 0; i < static_cast<size_t>(MemorySubsystem::Count); ++i)
+	{
+		m_hostCounters[i].bytes = 0;
+		m_hostCounters[i].peakBytes = 0;
+		m_hostCounters[i].allocations = 0;
+		m_hostCounters[i].internalBytes = 0;
+
+		m_deviceBytes[i] = 0;
+		m_deviceAllocationCounts[i] = 0;
+
+		m_scopes[i].tracker = this;
+		m_scopes[i].subsystem = static_cast<MemorySubsystem>(i);
+
+		m_callbacks[i] = {};
+		m_callbacks[i].pUserData = &m_scopes[i];
+		m_callbacks[i].pfnAllocation = allocationCallback;
+		m_callbacks[i].pfnReallocation = reallocationCallback;
+		m_callbacks[i].pfnFree = freeCallback;
+		m_callbacks[i].pfnInternalAllocation = internalAllocationCallback;
+		m_callbacks[i].pfnInternalFree = internalFreeCallback;
+	}
+}
+
+void* VKAPI_PTR MemoryTracker::allocationCallback(void* userData, size_t size, size_t alignment,
+	VkSystemAllocationScope)
+{
+	CallbackScope* scope = static_cast<CallbackScope*>(userData);
+	return scope->tracker->allocateHost(scope->subsystem, size, alignment);
+}
+
+void* VKAPI_PTR MemoryTracker::reallocationCallback(void* userData, void* original, size_t size, size_t alignment,
+	VkSystemAllocationScope)
+{
+	CallbackScope* scope = static_cast<CallbackScope*>(userData);
+
+	if (original == nullptr)
+	{
+		return scope->tracker->allocateHost(scope->subsystem, size, alignment);
+	}
+
+	if (size == 0)
+	{
+		scope->tracker->freeHost(original);
+		return nullptr;
+	}
+
+	void* memory = scope->tracker->allocateHost(scope->subsystem, size, alignment);
+	if (memory == nullptr)
+	{
+		return nullptr;
+	}
+
+	std::memcpy(memory, original, std::min(size, readHeader(original).size));
+	scope->tracker->freeHost(original);
+
+	return memory;
+}
+
+void VKAPI_PTR MemoryTracker::freeCallback(void* userData, void* memory)
+{
+	static_cast<CallbackScope*>(userData)->tracker->freeHost(memory);
+}
+
+void VKAPI_PTR MemoryTracker::internalAllocationCallback(void* userData, size_t size, VkInternalAllocationType,
+	VkSystemAllocationScope)
+{
+	CallbackScope* scope = static_cast<CallbackScope*>(userData);
+	scope->tracker->m_hostCounters[static_cast<size_t>(scope->subsystem)].internalBytes += size;
+}
+
+void VKAPI_PTR MemoryTracker::internalFreeCallback(void* userData, size_t size, VkInternalAllocationType,
+	VkSystemAllocationScope)
+{
+	CallbackScope* scope = static_cast<CallbackScope*>(userData);
+	scope->tracker->m_hostCounters[static_cast<size_t>(scope->subsystem)].internalBytes -= size;
+}
+
+void* MemoryTracker::allocateHost(MemorySubsystem subsystem, size_t size, size_t alignment)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	alignment = std::max(alignment, alignof(std::max_align_t));
+
+	void* block = std::malloc(size + alignment + sizeof(AllocationHeader));
+	if (block == nullptr)
+	{
+		return nullptr;
+	}
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(block) + sizeof(AllocationHeader);
+	address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	void* memory = reinterpret_cast<void*>(address);
+
+	AllocationHeader header = { block, size, subsystem };
+	std::memcpy(static_cast<char*>(memory) - sizeof(AllocationHeader), &header, sizeof(AllocationHeader));
+
+	HostCounters& counters = m_hostCounters[static_cast<size_t>(subsystem)];
+	uint64_t bytes = counters.bytes += size;
+	++counters.allocations;
+
+	uint64_t peakBytes = counters.peakBytes;
+	while (bytes > peakBytes && !counters.peakBytes.compare_exchange_weak(peakBytes, bytes))
+	{
+	}
+
+	return memory;
+}
+
+void MemoryTracker::freeHost(void* memory)
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	AllocationHeader header = readHeader(memory);
+
+	HostCounters& counters = m_hostCounters[static_cast<size_t>(header.subsystem)];
+	counters.bytes -= header.size;
+	--counters.allocations;
+
+	std::free(header.block);
+}
+
+const VkAllocationCallbacks* MemoryTracker::getAllocationCallbacks(MemorySubsystem subsystem) const
+{
+	return &m_callbacks[static_cast<size_t>(subsystem)];
+}
+
+void MemoryTracker::bindPhysicalDevice(VkPhysicalDevice physicalDevice,
+	PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_vkPhysicalDevice = physicalDevice;
+	m_getMemoryProperties2 = getMemoryProperties2;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_vkMemoryProperties);
+
+	m_heapTrackedBytes.assign(m_vkMemoryProperties.memoryHeapCount, 0);
+	m_overBudget.assign(m_vkMemoryProperties.memoryHeapCount, false);
+}
+
+void MemoryTracker::recordDeviceAllocation(VkDeviceMemory memory, uint32_t memoryTypeIndex, VkDeviceSize size,
+	MemorySubsystem subsystem)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	DeviceAllocation allocation;
+	allocation.subsystem = subsystem;
+	allocation.heapIndex = m_vkMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	allocation.size = size;
+
+	m_deviceAllocations[memory] = allocation;
+	m_deviceBytes[static_cast<size_t>(subsystem)] += size;
+	++m_deviceAllocationCounts[static_cast<size_t>(subsystem)];
+	m_heapTrackedBytes[allocation.heapIndex] += size;
+}
+
+void MemoryTracker::recordDeviceFree(VkDeviceMemory memory)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_deviceAllocations.find(memory);
+	if (it == m_deviceAllocations.end())
+	{
+		return;
+	}
+
+	const DeviceAllocation& allocation = it->second;
+	m_deviceBytes[static_cast<size_t>(allocation.subsystem)] -= allocation.size;
+	--m_deviceAllocationCounts[static_cast<size_t>(allocation.subsystem)];
+	m_heapTrackedBytes[allocation.heapIndex] -= allocation.size;
+
+	m_deviceAllocations.erase(it);
+}
+
+void MemoryTracker::addBudgetCallback(BudgetCallback callback)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_budgetCallbacks.push_back(callback);
+}
+
+void MemoryTracker::update(uint64_t frameNumber)
+{
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+	if (m_getMemoryProperties2 != nullptr)
+	{
+		VkPhysicalDeviceMemoryProperties2KHR memoryProperties = {};
+		memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+		memoryProperties.pNext = &budgetProperties;
+
+		m_getMemoryProperties2(m_vkPhysicalDevice, &memoryProperties);
+	}
+
+	std::vector<MemoryBudgetEvent> events;
+	std::vector<BudgetCallback> callbacks;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_stats.frameNumber = frameNumber;
+		m_stats.budgetQueried = m_getMemoryProperties2 != nullptr;
+		m_stats.heaps.resize(m_vkMemoryProperties.memoryHeapCount);
+		m_stats.subsystems.resize(static_cast<size_t>(MemorySubsystem::Count));
+
+		for (uint32_t i = 0; i < m_vkMemoryProperties.memoryHeapCount; ++i)
+		{
+			MemoryHeapStats& heap = m_stats.heaps[i];
+			heap.size = m_vkMemoryProperties.memoryHeaps[i].size;
+			heap.trackedBytes = m_heapTrackedBytes[i];
+			heap.deviceLocal = (m_vkMemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			heap.budget = m_stats.budgetQueried ? budgetProperties.heapBudget[i] : heap.size;
+			heap.usage = m_stats.budgetQueried ? budgetProperties.heapUsage[i] : heap.trackedBytes;
+
+			bool overBudget = heap.usage > static_cast<VkDeviceSize>(heap.budget * m_budgetThreshold);
+			if (overBudget && !m_overBudget[i])
+			{
+				events.push_back({ i, heap.budget, heap.usage });
+			}
+
+			m_overBudget[i] = overBudget;
+		}
+
+		for (size_t i = 0; i < m_stats.subsystems.size(); ++i)
+		{
+			MemorySubsystemStats& subsystem = m_stats.subsystems[i];
+			subsystem.hostBytes = m_hostCounters[i].bytes;
+			subsystem.hostPeakBytes = m_hostCounters[i].peakBytes;
+			subsystem.hostAllocations = m_hostCounters[i].allocations;
+			subsystem.hostInternalBytes = m_hostCounters[i].internalBytes;
+			subsystem.deviceBytes = m_deviceBytes[i];
+			subsystem.deviceAllocations = m_deviceAllocationCounts[i];
+		}
+
+		if (!events.empty())
+		{
+			callbacks = m_budgetCallbacks;
+		}
+	}
+
+	for (const MemoryBudgetEvent& event : events)
+	{
+		for (const BudgetCallback& callback : callbacks)
+		{
+			callback(event);
+		}
+	}
+}
+
+MemoryStats MemoryTracker::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+void MemoryTracker::writeJson(std::ostream& stream) const
+{
+	MemoryStats stats = getStats();
+
+	stream << "{\n";
+	stream << "\t\"frame\": " << stats.frameNumber << ",\n";
+	stream << "\t\"budgetQueried\": " << (stats.budgetQueried ? "true" : "false") << ",\n";
+	stream << "\t\"heaps\": [";
+
+	for (size_t i = 0; i < stats.heaps.size(); ++i)
+	{
+		const MemoryHeapStats& heap = stats.heaps[i];
+
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "\t\t{ \"index\": " << i
+			<< ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+			<< ", \"size\": " << heap.size
+			<< ", \"budget\": " << heap.budget
+			<< ", \"usage\": " << heap.usage
+			<< ", \"tracked\": " << heap.trackedBytes << " }";
+	}
+
+	stream << "\n\t],\n";
+	stream << "\t\"subsystems\": {";
+
+	for (size_t i = 0; i < stats.subsystems.size(); ++i)
+	{
+		const MemorySubsystemStats& subsystem = stats.subsystems[i];
+
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "\t\t\"" << memorySubsystemName(static_cast<MemorySubsystem>(i)) << "\": {"
+			<< " \"hostBytes\": " << subsystem.hostBytes
+			<< ", \"hostPeakBytes\": " << subsystem.hostPeakBytes
+			<< ", \"hostAllocations\": " << subsystem.hostAllocations
+			<< ", \"hostInternalBytes\": " << subsystem.hostInternalBytes
+			<< ", \"deviceBytes\": " << subsystem.deviceBytes
+			<< ", \"deviceAllocations\": " << subsystem.deviceAllocations << " }";
+	}
+
+	stream << "\n\t}\n";
+	stream << "}\n";
+}
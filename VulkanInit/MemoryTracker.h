@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+enum class MemorySubsystem
+{
+	Core,
+	Swapchain,
+	RenderTargets,
+	Buffers,
+	Pipelines,
+	Descriptors,
+	Commands,
+	Sync,
+	Capture,
+	Hud,
+	Count
+};
+
+const char* memorySubsystemName(MemorySubsystem subsystem);
+
+struct MemorySubsystemStats
+{
+	uint64_t hostBytes;
+	uint64_t hostPeakBytes;
+	uint64_t hostAllocations;
+	uint64_t hostInternalBytes;
+	uint64_t deviceBytes;
+	uint64_t deviceAllocations;
+};
+
+struct MemoryHeapStats
+{
+	VkDeviceSize size;
+	VkDeviceSize budget;
+	VkDeviceSize usage;
+	VkDeviceSize trackedBytes;
+	bool deviceLocal;
+};
+
+struct MemoryStats
+{
+	uint64_t frameNumber;
+	bool budgetQueried;
+	std::vector<MemoryHeapStats> heaps;
+	std::vector<MemorySubsystemStats> subsystems;
+};
+
+struct MemoryBudgetEvent
+{
+	uint32_t heapIndex;
+	VkDeviceSize budget;
+	VkDeviceSize usage;
+};
+
+// Counts host allocations made by the driver through VkAllocationCallbacks and
+// device allocations reported by the engine, both tagged by subsystem. Heap
+// budgets come from VK_EXT_memory_budget when the device exposes it; otherwise
+// the heap size is the budget and tracked allocations are the usage.
+class MemoryTracker
+{
+public:
+	typedef std::function<void(const MemoryBudgetEvent&)> BudgetCallback;
+
+private:
+	struct HostCounters
+	{
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> peakBytes;
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> internalBytes;
+	};
+
+	struct DeviceAllocation
+	{
+		MemorySubsystem subsystem;
+		uint32_t heapIndex;
+		VkDeviceSize size;
+	};
+
+	struct CallbackScope
+	{
+		MemoryTracker* tracker;
+		MemorySubsystem subsystem;
+	};
+
+	float m_budgetThreshold;
+	HostCounters m_hostCounters[static_cast<size_t>(MemorySubsystem::Count)];
+	CallbackScope m_scopes[static_cast<size_t>(MemorySubsystem::Count)];
+	VkAllocationCallbacks m_callbacks[static_cast<size_t>(MemorySubsystem::Count)];
+
+	VkPhysicalDevice m_vkPhysicalDevice;
+	VkPhysicalDeviceMemoryProperties m_vkMemoryProperties;
+	PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_getMemoryProperties2;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<VkDeviceMemory, DeviceAllocation> m_deviceAllocations;
+	uint64_t m_deviceBytes[static_cast<size_t>(MemorySubsystem::Count)];
+	uint64_t m_deviceAllocationCounts[static_cast<size_t>(MemorySubsystem::Count)];
+	std::vector<VkDeviceSize> m_heapTrackedBytes;
+	std::vector<BudgetCallback> m_budgetCallbacks;
+	std::vector<bool> m_overBudget;
+	MemoryStats m_stats;
+
+	static void* VKAPI_PTR allocationCallback(void* userData, size_t size, size_t alignment,
+		VkSystemAllocationScope scope);
+	static void* VKAPI_PTR reallocationCallback(void* userData, void* original, size_t size, size_t alignment,
+		VkSystemAllocationScope scope);
+	static void VKAPI_PTR freeCallback(void* userData, void* memory);
+	static void VKAPI_PTR internalAllocationCallback(void* userData, size_t size, VkInternalAllocationType type,
+		VkSystemAllocationScope scope);
+	static void VKAPI_PTR internalFreeCallback(void* userData, size_t size, VkInternalAllocationType type,
+		VkSystemAllocationScope scope);
+
+	void* allocateHost(MemorySubsystem subsystem, size_t size, size_t alignment);
+	void freeHost(void* memory);
+
+public:
+	explicit MemoryTracker(float budgetThreshold);
+
+	MemoryTracker(const MemoryTracker&) = delete;
+	MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+	const VkAllocationCallbacks* getAllocationCallbacks(MemorySubsystem subsystem) const;
+
+	void bindPhysicalDevice(VkPhysicalDevice physicalDevice, PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2);
+	void recordDeviceAllocation(VkDeviceMemory memory, uint32_t memoryTypeIndex, VkDeviceSize size, MemorySubsystem subsystem);
+	void recordDeviceFree(VkDeviceMemory memory);
+
+	void addBudgetCallback(BudgetCallback callback);
+	void update(uint64_t frameNumber);
+	MemoryStats getStats() const;
+	void writeJson(std::ostream& stream) const;
+};
@@ -0,0 +1,669 @@
+#include "Engine.h"
+#include "VulkanUtils.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	struct CullPushConstants
+	{
+		glm::mat4 viewProjection;
+		uint32_t instanceCount;
+		uint32_t latePhase;
+		uint32_t pyramidWidth;
+		uint32_t pyramidHeight;
+	};
+
+	struct OcclusionCounters
+	{
+		uint32_t drawnEarly;
+		uint32_t drawnLate;
+		uint32_t occluded;
+		uint32_t frustumCulled;
+	};
+
+	const uint32_t CULL_GROUP_SIZE = 64;
+	const uint32_t DEPTH_PYRAMID_GROUP_SIZE = 8;
+
+	uint32_t previousPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+
+		while (result * 2 <= value)
+		{
+			result *= 2;
+		}
+
+		return result;
+	}
+}
+
+void Engine::chooseDepthFormat()
+{
+	m_vkDepthFormat = VK_FORMAT_D32_SFLOAT;
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_vkPhysicalDevice, m_vkDepthFormat, &formatProperties);
+
+	VkFormatFeatureFlags requiredFeatures =
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+	if ((formatProperties.optimalTilingFeatures & requiredFeatures) != requiredFeatures)
+	{
+		throw std::runtime_error("Depth format cannot be sampled.");
+	}
+}
+
+void Engine::createDepthResources()
+{
+	createImage(m_vkSwapchainExtent.width, m_vkSwapchainExtent.height, 1, m_vkDepthFormat,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		m_vkDepthImage, m_vkDepthImageMemory, MemorySubsystem::RenderTargets);
+
+	m_vkDepthImageView = createImageView(m_vkDepthImage, m_vkDepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1);
+}
+
+void Engine::createOcclusionRenderPasses()
+{
+	VkAttachmentDescription attachments[2] = {};
+
+	VkAttachmentDescription& colorAttachment = attachments[0];
+	colorAttachment.format = m_vkSwapchainImageFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription& depthAttachment = attachments[1];
+	depthAttachment.format = m_vkDepthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef = {};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef = {};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	VkSubpassDependency dependencies[2] = {};
+
+	VkSubpassDependency& inputDependency = dependencies[0];
+	inputDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	inputDependency.dstSubpass = 0;
+	inputDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	inputDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	inputDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	inputDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	VkSubpassDependency& outputDependency = dependencies[1];
+	outputDependency.srcSubpass = 0;
+	outputDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+	outputDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	outputDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	outputDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	outputDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassCreateInfo.attachmentCount = 2;
+	renderPassCreateInfo.pAttachments = attachments;
+	renderPassCreateInfo.subpassCount = 1;
+	renderPassCreateInfo.pSubpasses = &subpass;
+	renderPassCreateInfo.dependencyCount = 2;
+	renderPassCreateInfo.pDependencies = dependencies;
+
+	VkResult result = vkCreateRenderPass(m_vkDevice, &renderPassCreateInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkRenderPass);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create render pass.");
+	}
+
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout = m_vkPresentLayout;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	renderPassCreateInfo.dependencyCount = 1;
+
+	result = vkCreateRenderPass(m_vkDevice, &renderPassCreateInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkLateRenderPass);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create late render pass.");
+	}
+}
+
+void Engine::createOcclusionResources()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t instanceCount = m_settings.sceneInstanceCount;
+	if (instanceCount > properties.limits.maxDrawIndirectCount)
+	{
+		throw std::runtime_error("Scene instance count exceeds the indirect draw limit.");
+	}
+
+	std::vector<SceneInstance> instances = generateCityScene(instanceCount);
+	m_sceneCamera = createSceneCamera(instanceCount,
+		static_cast<float>(m_vkSwapchainExtent.width) / static_cast<float>(m_vkSwapchainExtent.height));
+
+	streamUpload(CommandStreamUpload::SceneInstances, instances.data(), sizeof(SceneInstance) * instances.size());
+	streamUpload(CommandStreamUpload::SceneCamera, &m_sceneCamera, sizeof(SceneCamera));
+
+	VkDeviceSize instanceBufferSize = sizeof(SceneInstance) * instanceCount;
+	createBuffer(instanceBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_vkInstanceBuffer, m_vkInstanceBufferMemory, MemorySubsystem::Buffers);
+
+	void* data;
+	vkMapMemory(m_vkDevice, m_vkInstanceBufferMemory, 0, instanceBufferSize, 0, &data);
+	memcpy(data, instances.data(), static_cast<size_t>(instanceBufferSize));
+	vkUnmapMemory(m_vkDevice, m_vkInstanceBufferMemory);
+
+	createBuffer(sizeof(VkDrawIndirectCommand) * instanceCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkDrawCommandBuffer, m_vkDrawCommandBufferMemory,
+		MemorySubsystem::Buffers);
+
+	createBuffer(sizeof(uint32_t) * instanceCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkVisibilityBuffer, m_vkVisibilityBufferMemory,
+		MemorySubsystem::Buffers);
+
+	// Counters and timestamps are per frame slot: the host reads a slot only
+	// after waiting for its frame, which no other frame in flight writes to.
+	m_vkOcclusionStatsBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	m_vkOcclusionStatsBufferMemories.resize(MAX_FRAMES_IN_FLIGHT);
+	m_occlusionStatsMappings.resize(MAX_FRAMES_IN_FLIGHT);
+
+	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		createBuffer(sizeof(OcclusionCounters),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			m_vkOcclusionStatsBuffers[i], m_vkOcclusionStatsBufferMemories[i], MemorySubsystem::Buffers);
+
+		vkMapMemory(m_vkDevice, m_vkOcclusionStatsBufferMemories[i], 0, sizeof(OcclusionCounters), 0,
+			&m_occlusionStatsMappings[i]);
+		memset(m_occlusionStatsMappings[i], 0, sizeof(OcclusionCounters));
+	}
+
+	createDepthPyramid();
+	createOcclusionDescriptors();
+
+	m_vkOcclusionQueryPool = VK_NULL_HANDLE;
+
+	if (properties.limits.timestampComputeAndGraphics)
+	{
+		VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = MAX_FRAMES_IN_FLIGHT * OCCLUSION_TIMESTAMP_COUNT;
+
+		VkResult result = vkCreateQueryPool(m_vkDevice, &queryPoolCreateInfo, hostAllocator(MemorySubsystem::Sync), &m_vkOcclusionQueryPool);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create query pool.");
+		}
+	}
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	vkCmdFillBuffer(commandBuffer, m_vkVisibilityBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	VkImageMemoryBarrier pyramidBarrier = {};
+	pyramidBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	pyramidBarrier.srcAccessMask = 0;
+	pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.image = m_vkDepthPyramid;
+	pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	pyramidBarrier.subresourceRange.baseMipLevel = 0;
+	pyramidBarrier.subresourceRange.levelCount = m_depthPyramidLevels;
+	pyramidBarrier.subresourceRange.baseArrayLayer = 0;
+	pyramidBarrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &pyramidBarrier);
+
+	endSingleTimeCommands(commandBuffer);
+
+	m_occlusionStats = {};
+	m_occlusionStats.instanceCount = instanceCount;
+}
+
+void Engine::createDepthPyramid()
+{
+	m_depthPyramidExtent.width = previousPowerOfTwo(m_vkSwapchainExtent.width);
+	m_depthPyramidExtent.height = previousPowerOfTwo(m_vkSwapchainExtent.height);
+
+	m_depthPyramidLevels = 1;
+	uint32_t size = std::max(m_depthPyramidExtent.width, m_depthPyramidExtent.height);
+
+	while (size > 1)
+	{
+		size /= 2;
+		++m_depthPyramidLevels;
+	}
+
+	createImage(m_depthPyramidExtent.width, m_depthPyramidExtent.height, m_depthPyramidLevels,
+		VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		m_vkDepthPyramid, m_vkDepthPyramidMemory, MemorySubsystem::RenderTargets);
+
+	m_vkDepthPyramidView = createImageView(m_vkDepthPyramid, VK_FORMAT_R32_SFLOAT,
+		VK_IMAGE_ASPECT_COLOR_BIT, 0, m_depthPyramidLevels);
+
+	m_vkDepthPyramidMipViews.resize(m_depthPyramidLevels);
+
+	for (uint32_t level = 0; level < m_depthPyramidLevels; ++level)
+	{
+		m_vkDepthPyramidMipViews[level] = createImageView(m_vkDepthPyramid, VK_FORMAT_R32_SFLOAT,
+			VK_IMAGE_ASPECT_COLOR_BIT, level, 1);
+	}
+
+	VkSamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = static_cast<float>(m_depthPyramidLevels);
+
+	VkResult result = vkCreateSampler(m_vkDevice, &samplerCreateInfo, hostAllocator(MemorySubsystem::Descriptors), &m_vkDepthPyramidSampler);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create depth pyramid sampler.");
+	}
+}
+
+void Engine::createOcclusionDescriptorSetLayouts()
+{
+	const VkAllocationCallbacks* allocator = hostAllocator(MemorySubsystem::Descriptors);
+
+	m_vkSceneDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, allocator, {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+	});
+
+	m_vkCullDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, allocator, {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+	});
+
+	m_vkDepthPyramidDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, allocator, {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+	});
+}
+
+void Engine::createOcclusionDescriptors()
+{
+	uint32_t frameCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+
+	VkDescriptorPoolSize poolSizes[3] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[0].descriptorCount = 1 + 4 * frameCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = frameCount + m_depthPyramidLevels;
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[2].descriptorCount = m_depthPyramidLevels;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = 1 + frameCount + m_depthPyramidLevels;
+	poolCreateInfo.poolSizeCount = 3;
+	poolCreateInfo.pPoolSizes = poolSizes;
+
+	VkResult result = vkCreateDescriptorPool(m_vkDevice, &poolCreateInfo, hostAllocator(MemorySubsystem::Descriptors), &m_vkOcclusionDescriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool.");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	setLayouts.push_back(m_vkSceneDescriptorSetLayout);
+	setLayouts.insert(setLayouts.end(), frameCount, m_vkCullDescriptorSetLayout);
+	setLayouts.insert(setLayouts.end(), m_depthPyramidLevels, m_vkDepthPyramidDescriptorSetLayout);
+
+	std::vector<VkDescriptorSet> sets(setLayouts.size());
+
+	VkDescriptorSetAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = m_vkOcclusionDescriptorPool;
+	allocateInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+	allocateInfo.pSetLayouts = setLayouts.data();
+
+	result = vkAllocateDescriptorSets(m_vkDevice, &allocateInfo, sets.data());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor sets.");
+	}
+
+	m_vkSceneDescriptorSet = sets[0];
+	m_vkCullDescriptorSets.assign(sets.begin() + 1, sets.begin() + 1 + frameCount);
+	m_vkDepthPyramidDescriptorSets.assign(sets.begin() + 1 + frameCount, sets.end());
+
+	VkDescriptorBufferInfo instanceInfo = { m_vkInstanceBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo drawCommandInfo = { m_vkDrawCommandBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo visibilityInfo = { m_vkVisibilityBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorImageInfo pyramidInfo = { m_vkDepthPyramidSampler, m_vkDepthPyramidView, VK_IMAGE_LAYOUT_GENERAL };
+
+	std::vector<VkDescriptorBufferInfo> statsInfos(frameCount);
+	std::vector<VkWriteDescriptorSet> writes;
+	writes.push_back(bufferWrite(m_vkSceneDescriptorSet, 0, &instanceInfo));
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		statsInfos[i] = { m_vkOcclusionStatsBuffers[i], 0, VK_WHOLE_SIZE };
+
+		writes.push_back(bufferWrite(m_vkCullDescriptorSets[i], 0, &instanceInfo));
+		writes.push_back(bufferWrite(m_vkCullDescriptorSets[i], 1, &drawCommandInfo));
+		writes.push_back(bufferWrite(m_vkCullDescriptorSets[i], 2, &visibilityInfo));
+		writes.push_back(bufferWrite(m_vkCullDescriptorSets[i], 3, &statsInfos[i]));
+		writes.push_back(imageWrite(m_vkCullDescriptorSets[i], 4,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &pyramidInfo));
+	}
+
+	std::vector<VkDescriptorImageInfo> sourceInfos(m_depthPyramidLevels);
+	std::vector<VkDescriptorImageInfo> destinationInfos(m_depthPyramidLevels);
+
+	for (uint32_t level = 0; level < m_depthPyramidLevels; ++level)
+	{
+		if (level == 0)
+		{
+			sourceInfos[level] = { m_vkDepthPyramidSampler, m_vkDepthImageView,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		}
+		else
+		{
+			sourceInfos[level] = { m_vkDepthPyramidSampler, m_vkDepthPyramidMipViews[level - 1],
+				VK_IMAGE_LAYOUT_GENERAL };
+		}
+
+		destinationInfos[level] = { VK_NULL_HANDLE, m_vkDepthPyramidMipViews[level], VK_IMAGE_LAYOUT_GENERAL };
+
+		writes.push_back(imageWrite(m_vkDepthPyramidDescriptorSets[level], 0,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &sourceInfos[level]));
+		writes.push_back(imageWrite(m_vkDepthPyramidDescriptorSets[level], 1,
+			VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &destinationInfos[level]));
+	}
+
+	vkUpdateDescriptorSets(m_vkDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void Engine::createOcclusionPipelines()
+{
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullPushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_vkCullDescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkCullPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	pipelineLayoutInfo.pSetLayouts = &m_vkDepthPyramidDescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+	result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkDepthPyramidPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	m_vkCullPipeline = createComputePipeline("occlusion_cull.spv", m_vkCullPipelineLayout);
+	m_vkDepthPyramidPipeline = createComputePipeline("depth_pyramid.spv", m_vkDepthPyramidPipelineLayout);
+}
+
+void Engine::recordOcclusionCommands(VkCommandBuffer commandBuffer, size_t imageIndex, VkPipeline pipeline)
+{
+	uint32_t instanceCount = m_settings.sceneInstanceCount;
+	uint32_t firstQuery = static_cast<uint32_t>(m_currentFrame) * OCCLUSION_TIMESTAMP_COUNT;
+
+	auto writeTimestamp = [&](VkPipelineStageFlagBits stage, uint32_t query)
+	{
+		if (m_vkOcclusionQueryPool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(commandBuffer, stage, m_vkOcclusionQueryPool, firstQuery + query);
+		}
+	};
+
+	CullPushConstants cullConstants = {};
+	cullConstants.viewProjection = m_sceneCamera.viewProjection;
+	cullConstants.instanceCount = instanceCount;
+	cullConstants.pyramidWidth = m_depthPyramidExtent.width;
+	cullConstants.pyramidHeight = m_depthPyramidExtent.height;
+
+	auto dispatchCull = [&](uint32_t latePhase)
+	{
+		cullConstants.latePhase = latePhase;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkCullPipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkCullPipelineLayout,
+			0, 1, &m_vkCullDescriptorSets[m_currentFrame], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_vkCullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+			0, sizeof(CullPushConstants), &cullConstants);
+		vkCmdDispatch(commandBuffer, (instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+		memoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	};
+
+	VkClearValue clearValues[2] = {};
+	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+
+	auto drawScene = [&](VkRenderPass renderPass)
+	{
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = m_vkSwapchainFramebuffers[imageIndex];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = m_vkSwapchainExtent;
+		renderPassInfo.clearValueCount = 2;
+		renderPassInfo.pClearValues = clearValues;
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vkPipelineLayout,
+			0, 1, &m_vkSceneDescriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_vkPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+			0, sizeof(glm::mat4), &m_sceneCamera.viewProjection);
+		vkCmdDrawIndirect(commandBuffer, m_vkDrawCommandBuffer, 0, instanceCount, sizeof(VkDrawIndirectCommand));
+		m_pendingFrameStats[m_currentFrame].drawCount += instanceCount;
+		vkCmdEndRenderPass(commandBuffer);
+	};
+
+	if (m_vkOcclusionQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_vkOcclusionQueryPool, firstQuery, OCCLUSION_TIMESTAMP_COUNT);
+	}
+
+	vkCmdFillBuffer(commandBuffer, m_vkOcclusionStatsBuffers[m_currentFrame], 0, VK_WHOLE_SIZE, 0);
+
+	memoryBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+	dispatchCull(0);
+	writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+	drawScene(m_vkRenderPass);
+	writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2);
+	recordDepthPyramidBuild(commandBuffer);
+	writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 3);
+
+	memoryBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	dispatchCull(1);
+	writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 4);
+	drawScene(m_vkLateRenderPass);
+	writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 5);
+
+	memoryBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+}
+
+void Engine::recordDepthPyramidBuild(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkDepthPyramidPipeline);
+
+	for (uint32_t level = 0; level < m_depthPyramidLevels; ++level)
+	{
+		uint32_t width = std::max(m_depthPyramidExtent.width >> level, 1u);
+		uint32_t height = std::max(m_depthPyramidExtent.height >> level, 1u);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkDepthPyramidPipelineLayout,
+			0, 1, &m_vkDepthPyramidDescriptorSets[level], 0, nullptr);
+		vkCmdDispatch(commandBuffer,
+			(width + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE,
+			(height + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE,
+			1);
+
+		memoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+}
+
+void Engine::collectOcclusionStats(uint32_t frameSlot)
+{
+	const OcclusionCounters* counters = static_cast<const OcclusionCounters*>(m_occlusionStatsMappings[frameSlot]);
+
+	m_occlusionStats.drawnEarly = counters->drawnEarly;
+	m_occlusionStats.drawnLate = counters->drawnLate;
+	m_occlusionStats.occluded = counters->occluded;
+	m_occlusionStats.frustumCulled = counters->frustumCulled;
+
+	if (m_vkOcclusionQueryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	uint64_t timestamps[6];
+	VkResult result = vkGetQueryPoolResults(m_vkDevice, m_vkOcclusionQueryPool,
+		frameSlot * OCCLUSION_TIMESTAMP_COUNT, OCCLUSION_TIMESTAMP_COUNT,
+		sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	double nanosecondsToMilliseconds = static_cast<double>(m_timestampPeriod) / 1000000.0;
+	double earlyCull = static_cast<double>(timestamps[1] - timestamps[0]);
+	double earlyDraw = static_cast<double>(timestamps[2] - timestamps[1]);
+	double pyramidBuild = static_cast<double>(timestamps[3] - timestamps[2]);
+	double lateCull = static_cast<double>(timestamps[4] - timestamps[3]);
+	double lateDraw = static_cast<double>(timestamps[5] - timestamps[4]);
+
+	m_occlusionStats.cullingGpuTimeMs = (earlyCull + pyramidBuild + lateCull) * nanosecondsToMilliseconds;
+	m_occlusionStats.drawGpuTimeMs = (earlyDraw + lateDraw) * nanosecondsToMilliseconds;
+
+	uint32_t drawn = m_occlusionStats.drawnEarly + m_occlusionStats.drawnLate;
+	if (drawn > 0)
+	{
+		double drawTimePerInstance = m_occlusionStats.drawGpuTimeMs / drawn;
+		m_occlusionStats.savedGpuTimeMs =
+			drawTimePerInstance * m_occlusionStats.occluded - m_occlusionStats.cullingGpuTimeMs;
+	}
+}
+
+void Engine::destroyOcclusionResources()
+{
+	if (m_vkOcclusionQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(m_vkDevice, m_vkOcclusionQueryPool, hostAllocator(MemorySubsystem::Sync));
+	}
+
+	vkDestroyPipeline(m_vkDevice, m_vkCullPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipeline(m_vkDevice, m_vkDepthPyramidPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkCullPipelineLayout, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkDepthPyramidPipelineLayout, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyDescriptorPool(m_vkDevice, m_vkOcclusionDescriptorPool, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkSceneDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkCullDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkDepthPyramidDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+
+	for (size_t i = 0; i < m_vkOcclusionStatsBuffers.size(); ++i)
+	{
+		vkUnmapMemory(m_vkDevice, m_vkOcclusionStatsBufferMemories[i]);
+		vkDestroyBuffer(m_vkDevice, m_vkOcclusionStatsBuffers[i], hostAllocator(MemorySubsystem::Buffers));
+		freeDeviceMemory(m_vkOcclusionStatsBufferMemories[i]);
+	}
+
+	vkDestroyBuffer(m_vkDevice, m_vkVisibilityBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkVisibilityBufferMemory);
+	vkDestroyBuffer(m_vkDevice, m_vkDrawCommandBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkDrawCommandBufferMemory);
+	vkDestroyBuffer(m_vkDevice, m_vkInstanceBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkInstanceBufferMemory);
+
+	vkDestroySampler(m_vkDevice, m_vkDepthPyramidSampler, hostAllocator(MemorySubsystem::Descriptors));
+
+	for (VkImageView mipView : m_vkDepthPyramidMipViews)
+	{
+		vkDestroyImageView(m_vkDevice, mipView, hostAllocator(MemorySubsystem::RenderTargets));
+	}
+
+	vkDestroyImageView(m_vkDevice, m_vkDepthPyramidView, hostAllocator(MemorySubsystem::RenderTargets));
+	vkDestroyImage(m_vkDevice, m_vkDepthPyramid, hostAllocator(MemorySubsystem::RenderTargets));
+	freeDeviceMemory(m_vkDepthPyramidMemory);
+
+	vkDestroyRenderPass(m_vkDevice, m_vkLateRenderPass, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyImageView(m_vkDevice, m_vkDepthImageView, hostAllocator(MemorySubsystem::RenderTargets));
+	vkDestroyImage(m_vkDevice, m_vkDepthImage, hostAllocator(MemorySubsystem::RenderTargets));
+	freeDeviceMemory(m_vkDepthImageMemory);
+}
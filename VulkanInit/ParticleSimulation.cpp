@@ -0,0 +1,555 @@
+#include "Engine.h"
+#include "VulkanUtils.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+	struct Particle
+	{
+		glm::vec4 position;
+		glm::vec4 velocity;
+	};
+
+	struct SimulatePushConstants
+	{
+		glm::mat4 viewProjection;
+		uint32_t particleCount;
+		uint32_t frameIndex;
+		float timeStep;
+	};
+
+	struct RadixSortPushConstants
+	{
+		uint32_t keyCount;
+		uint32_t shift;
+		uint32_t groupCount;
+	};
+
+	struct ParticleDrawPushConstants
+	{
+		glm::mat4 viewProjection;
+		glm::vec4 quadSize;
+	};
+
+	const uint32_t SIMULATE_GROUP_SIZE = 256;
+	const uint32_t RADIX_SORT_GROUP_SIZE = 256;
+	const uint32_t RADIX_SORT_KEYS_PER_THREAD = 16;
+	const uint32_t RADIX_SORT_RADIX = 256;
+	const uint32_t RADIX_SORT_PASSES = 4;
+	const uint32_t PARTICLE_QUAD_VERTEX_COUNT = 6;
+	const float PARTICLE_TIME_STEP = 1.0f / 60.0f;
+	const float PARTICLE_SIZE = 0.04f;
+}
+
+void Engine::createParticleDescriptorSetLayouts()
+{
+	const VkAllocationCallbacks* allocator = hostAllocator(MemorySubsystem::Descriptors);
+
+	m_vkParticleSimulateDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, allocator, {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+	});
+
+	m_vkRadixSortDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, allocator, {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+	});
+
+	m_vkParticleDrawDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, allocator, {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+	});
+}
+
+void Engine::createParticleResources()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t particleCount = m_settings.particleCount;
+	uint32_t keysPerGroup = RADIX_SORT_GROUP_SIZE * RADIX_SORT_KEYS_PER_THREAD;
+	m_radixSortGroupCount = (particleCount + keysPerGroup - 1) / keysPerGroup;
+
+	if ((particleCount + SIMULATE_GROUP_SIZE - 1) / SIMULATE_GROUP_SIZE > properties.limits.maxComputeWorkGroupCount[0])
+	{
+		throw std::runtime_error("Particle count exceeds the compute dispatch limit.");
+	}
+
+	m_particleCamera = createParticleCamera(
+		static_cast<float>(m_vkSwapchainExtent.width) / static_cast<float>(m_vkSwapchainExtent.height));
+
+	streamUpload(CommandStreamUpload::ParticleCamera, &m_particleCamera, sizeof(SceneCamera));
+
+	VkDeviceSize particleBufferSize = sizeof(Particle) * particleCount;
+	VkDeviceSize sortBufferSize = sizeof(uint32_t) * particleCount;
+
+	m_vkParticleBuffers.resize(2);
+	m_vkParticleBufferMemories.resize(2);
+	m_vkSortKeyBuffers.resize(2);
+	m_vkSortKeyBufferMemories.resize(2);
+	m_vkSortValueBuffers.resize(2);
+	m_vkSortValueBufferMemories.resize(2);
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		createBuffer(particleBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkParticleBuffers[i], m_vkParticleBufferMemories[i],
+			MemorySubsystem::Buffers);
+
+		createBuffer(sortBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkSortKeyBuffers[i], m_vkSortKeyBufferMemories[i],
+			MemorySubsystem::Buffers);
+
+		createBuffer(sortBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkSortValueBuffers[i], m_vkSortValueBufferMemories[i],
+			MemorySubsystem::Buffers);
+	}
+
+	createBuffer(sortBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkSortScratchKeyBuffer, m_vkSortScratchKeyBufferMemory,
+		MemorySubsystem::Buffers);
+
+	createBuffer(sortBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkSortScratchValueBuffer, m_vkSortScratchValueBufferMemory,
+		MemorySubsystem::Buffers);
+
+	createBuffer(sizeof(uint32_t) * RADIX_SORT_RADIX * m_radixSortGroupCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vkSortHistogramBuffer, m_vkSortHistogramBufferMemory,
+		MemorySubsystem::Buffers);
+
+	createParticleDescriptors();
+
+	m_vkParticleQueryPool = VK_NULL_HANDLE;
+
+	if (properties.limits.timestampComputeAndGraphics)
+	{
+		VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = MAX_FRAMES_IN_FLIGHT * PARTICLE_TIMESTAMP_COUNT;
+
+		VkResult result = vkCreateQueryPool(m_vkDevice, &queryPoolCreateInfo, hostAllocator(MemorySubsystem::Sync), &m_vkParticleQueryPool);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create query pool.");
+		}
+	}
+
+	if (m_computeQueueFamily.has_value())
+	{
+		VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+		commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCreateInfo.queueFamilyIndex = *m_computeQueueFamily;
+		commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VkResult result = vkCreateCommandPool(m_vkDevice, &commandPoolCreateInfo, hostAllocator(MemorySubsystem::Commands), &m_vkComputeCommandPool);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create compute command pool.");
+		}
+
+		m_vkComputeCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+		VkCommandBufferAllocateInfo commandBufferInfo = {};
+		commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandBufferInfo.commandPool = m_vkComputeCommandPool;
+		commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferInfo.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+
+		result = vkAllocateCommandBuffers(m_vkDevice, &commandBufferInfo, m_vkComputeCommandBuffers.data());
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate compute command buffers.");
+		}
+
+		m_computeTimeline.reset(new TimelineSemaphore(m_vkDevice, hostAllocator(MemorySubsystem::Sync)));
+	}
+
+	// A zero lifetime makes the first simulation step spawn every particle.
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	for (VkBuffer particleBuffer : m_vkParticleBuffers)
+	{
+		vkCmdFillBuffer(commandBuffer, particleBuffer, 0, VK_WHOLE_SIZE, 0);
+	}
+
+	endSingleTimeCommands(commandBuffer);
+
+	m_particleComputeTotalMs = 0.0;
+	m_particleStats = {};
+	m_particleStats.particleCount = particleCount;
+	m_particleStats.asyncCompute = m_computeQueueFamily.has_value();
+}
+
+void Engine::createParticleDescriptors()
+{
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = 2 * 4 + 4 * 5 + 2 * 2;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = 2 + 4 + 2;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkResult result = vkCreateDescriptorPool(m_vkDevice, &poolCreateInfo, hostAllocator(MemorySubsystem::Descriptors), &m_vkParticleDescriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool.");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	setLayouts.insert(setLayouts.end(), 2, m_vkParticleSimulateDescriptorSetLayout);
+	setLayouts.insert(setLayouts.end(), 4, m_vkRadixSortDescriptorSetLayout);
+	setLayouts.insert(setLayouts.end(), 2, m_vkParticleDrawDescriptorSetLayout);
+
+	std::vector<VkDescriptorSet> sets(setLayouts.size());
+
+	VkDescriptorSetAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = m_vkParticleDescriptorPool;
+	allocateInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+	allocateInfo.pSetLayouts = setLayouts.data();
+
+	result = vkAllocateDescriptorSets(m_vkDevice, &allocateInfo, sets.data());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor sets.");
+	}
+
+	m_vkParticleSimulateDescriptorSets.assign(sets.begin(), sets.begin() + 2);
+	m_vkRadixSortDescriptorSets.assign(sets.begin() + 2, sets.begin() + 6);
+	m_vkParticleDrawDescriptorSets.assign(sets.begin() + 6, sets.end());
+
+	VkDescriptorBufferInfo particleInfos[2];
+	VkDescriptorBufferInfo keyInfos[2];
+	VkDescriptorBufferInfo valueInfos[2];
+	VkDescriptorBufferInfo scratchKeyInfo = { m_vkSortScratchKeyBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo scratchValueInfo = { m_vkSortScratchValueBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo histogramInfo = { m_vkSortHistogramBuffer, 0, VK_WHOLE_SIZE };
+
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		particleInfos[i] = { m_vkParticleBuffers[i], 0, VK_WHOLE_SIZE };
+		keyInfos[i] = { m_vkSortKeyBuffers[i], 0, VK_WHOLE_SIZE };
+		valueInfos[i] = { m_vkSortValueBuffers[i], 0, VK_WHOLE_SIZE };
+	}
+
+	// Frames alternate between the two particle buffers: a frame integrates
+	// from the buffer the previous frame wrote, and its sort ping-pongs between
+	// the frame's own key and value buffers and the shared scratch buffers so
+	// the final pass lands back in the frame's buffers.
+	std::vector<VkWriteDescriptorSet> writes;
+
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		VkDescriptorSet simulateSet = m_vkParticleSimulateDescriptorSets[i];
+		writes.push_back(bufferWrite(simulateSet, 0, &particleInfos[1 - i]));
+		writes.push_back(bufferWrite(simulateSet, 1, &particleInfos[i]));
+		writes.push_back(bufferWrite(simulateSet, 2, &keyInfos[i]));
+		writes.push_back(bufferWrite(simulateSet, 3, &valueInfos[i]));
+
+		VkDescriptorSet toScratchSet = m_vkRadixSortDescriptorSets[i * 2];
+		writes.push_back(bufferWrite(toScratchSet, 0, &keyInfos[i]));
+		writes.push_back(bufferWrite(toScratchSet, 1, &valueInfos[i]));
+		writes.push_back(bufferWrite(toScratchSet, 2, &scratchKeyInfo));
+		writes.push_back(bufferWrite(toScratchSet, 3, &scratchValueInfo));
+		writes.push_back(bufferWrite(toScratchSet, 4, &histogramInfo));
+
+		VkDescriptorSet fromScratchSet = m_vkRadixSortDescriptorSets[i * 2 + 1];
+		writes.push_back(bufferWrite(fromScratchSet, 0, &scratchKeyInfo));
+		writes.push_back(bufferWrite(fromScratchSet, 1, &scratchValueInfo));
+		writes.push_back(bufferWrite(fromScratchSet, 2, &keyInfos[i]));
+		writes.push_back(bufferWrite(fromScratchSet, 3, &valueInfos[i]));
+		writes.push_back(bufferWrite(fromScratchSet, 4, &histogramInfo));
+
+		VkDescriptorSet drawSet = m_vkParticleDrawDescriptorSets[i];
+		writes.push_back(bufferWrite(drawSet, 0, &particleInfos[i]));
+		writes.push_back(bufferWrite(drawSet, 1, &valueInfos[i]));
+	}
+
+	vkUpdateDescriptorSets(m_vkDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void Engine::createParticlePipelines()
+{
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(SimulatePushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_vkParticleSimulateDescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkParticleSimulatePipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	pushConstantRange.size = sizeof(RadixSortPushConstants);
+	pipelineLayoutInfo.pSetLayouts = &m_vkRadixSortDescriptorSetLayout;
+
+	result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Pipelines), &m_vkRadixSortPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	m_vkParticleSimulatePipeline = createComputePipeline("particle_simulate.spv", m_vkParticleSimulatePipelineLayout);
+	m_vkRadixHistogramPipeline = createComputePipeline("radix_histogram.spv", m_vkRadixSortPipelineLayout);
+	m_vkRadixScanPipeline = createComputePipeline("radix_scan.spv", m_vkRadixSortPipelineLayout);
+	m_vkRadixScatterPipeline = createComputePipeline("radix_scatter.spv", m_vkRadixSortPipelineLayout);
+}
+
+void Engine::recordParticleCompute(VkCommandBuffer commandBuffer)
+{
+	uint32_t particleCount = m_settings.particleCount;
+	uint32_t parity = static_cast<uint32_t>(m_frameNumber % 2);
+	uint32_t firstQuery = static_cast<uint32_t>(m_currentFrame) * PARTICLE_TIMESTAMP_COUNT;
+
+	auto writeTimestamp = [&](uint32_t query)
+	{
+		if (m_vkParticleQueryPool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkParticleQueryPool, firstQuery + query);
+		}
+	};
+
+	auto computeBarrier = [&]()
+	{
+		memoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	};
+
+	if (m_vkParticleQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_vkParticleQueryPool, firstQuery, 3);
+	}
+
+	memoryBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	writeTimestamp(0);
+
+	SimulatePushConstants simulateConstants = {};
+	simulateConstants.viewProjection = m_particleCamera.viewProjection;
+	simulateConstants.particleCount = particleCount;
+	simulateConstants.frameIndex = static_cast<uint32_t>(m_frameNumber);
+	simulateConstants.timeStep = PARTICLE_TIME_STEP;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkParticleSimulatePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkParticleSimulatePipelineLayout,
+		0, 1, &m_vkParticleSimulateDescriptorSets[parity], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_vkParticleSimulatePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+		0, sizeof(SimulatePushConstants), &simulateConstants);
+	vkCmdDispatch(commandBuffer, (particleCount + SIMULATE_GROUP_SIZE - 1) / SIMULATE_GROUP_SIZE, 1, 1);
+
+	computeBarrier();
+	writeTimestamp(1);
+
+	RadixSortPushConstants sortConstants = {};
+	sortConstants.keyCount = particleCount;
+	sortConstants.groupCount = m_radixSortGroupCount;
+
+	for (uint32_t pass = 0; pass < RADIX_SORT_PASSES; ++pass)
+	{
+		sortConstants.shift = pass * 8;
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkRadixSortPipelineLayout,
+			0, 1, &m_vkRadixSortDescriptorSets[parity * 2 + pass % 2], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_vkRadixSortPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+			0, sizeof(RadixSortPushConstants), &sortConstants);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkRadixHistogramPipeline);
+		vkCmdDispatch(commandBuffer, m_radixSortGroupCount, 1, 1);
+		computeBarrier();
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkRadixScanPipeline);
+		vkCmdDispatch(commandBuffer, 1, 1, 1);
+		computeBarrier();
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkRadixScatterPipeline);
+		vkCmdDispatch(commandBuffer, m_radixSortGroupCount, 1, 1);
+		computeBarrier();
+	}
+
+	writeTimestamp(2);
+
+	if (!m_computeQueueFamily.has_value())
+	{
+		memoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+}
+
+void Engine::recordParticleDraw(VkCommandBuffer commandBuffer, VkPipeline pipeline)
+{
+	uint32_t parity = static_cast<uint32_t>(m_frameNumber % 2);
+	uint32_t firstQuery = static_cast<uint32_t>(m_currentFrame) * PARTICLE_TIMESTAMP_COUNT;
+
+	ParticleDrawPushConstants drawConstants = {};
+	drawConstants.viewProjection = m_particleCamera.viewProjection;
+	drawConstants.quadSize = glm::vec4(
+		PARTICLE_SIZE * std::abs(m_particleCamera.projection[0][0]),
+		PARTICLE_SIZE * std::abs(m_particleCamera.projection[1][1]),
+		0.0f, 0.0f);
+
+	if (m_vkParticleQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_vkParticleQueryPool, firstQuery + 3);
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vkPipelineLayout,
+		0, 1, &m_vkParticleDrawDescriptorSets[parity], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_vkPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+		0, sizeof(ParticleDrawPushConstants), &drawConstants);
+	vkCmdDraw(commandBuffer, PARTICLE_QUAD_VERTEX_COUNT, m_settings.particleCount, 0, 0);
+	++m_pendingFrameStats[m_currentFrame].drawCount;
+
+	if (m_vkParticleQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkParticleQueryPool, firstQuery + 4);
+	}
+}
+
+uint64_t Engine::submitParticleCompute()
+{
+	VkCommandBuffer commandBuffer = m_vkComputeCommandBuffers[m_currentFrame];
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin command buffer.");
+	}
+
+	recordParticleCompute(commandBuffer);
+
+	result = vkEndCommandBuffer(commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer.");
+	}
+
+	// The buffers this submission overwrites were last read by the frame two
+	// frames back, which render() has already waited for on the host.
+	uint64_t computeValue = m_computeTimeline->nextValue();
+	VkSemaphore signalSemaphore = m_computeTimeline->getHandle();
+
+	VkTimelineSemaphoreSubmitInfoKHR timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &computeValue;
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &signalSemaphore;
+
+	result = vkQueueSubmit(m_vkComputeQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to queue compute submit.");
+	}
+
+	return computeValue;
+}
+
+void Engine::collectParticleStats(uint32_t frameSlot)
+{
+	if (m_vkParticleQueryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	uint64_t timestamps[5];
+	VkResult result = vkGetQueryPoolResults(m_vkDevice, m_vkParticleQueryPool,
+		frameSlot * PARTICLE_TIMESTAMP_COUNT, PARTICLE_TIMESTAMP_COUNT,
+		sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	double nanosecondsToMilliseconds = static_cast<double>(m_timestampPeriod) / 1000000.0;
+
+	m_particleStats.simulateGpuTimeMs = static_cast<double>(timestamps[1] - timestamps[0]) * nanosecondsToMilliseconds;
+	m_particleStats.sortGpuTimeMs = static_cast<double>(timestamps[2] - timestamps[1]) * nanosecondsToMilliseconds;
+	m_particleStats.drawGpuTimeMs = static_cast<double>(timestamps[4] - timestamps[3]) * nanosecondsToMilliseconds;
+
+	++m_particleStats.measuredFrames;
+	m_particleComputeTotalMs += m_particleStats.simulateGpuTimeMs + m_particleStats.sortGpuTimeMs;
+
+	if (m_particleComputeTotalMs > 0.0)
+	{
+		m_particleStats.particlesPerSecond = static_cast<double>(m_particleStats.particleCount) *
+			m_particleStats.measuredFrames / (m_particleComputeTotalMs / 1000.0);
+	}
+}
+
+void Engine::destroyParticleResources()
+{
+	if (m_computeQueueFamily.has_value())
+	{
+		m_computeTimeline->destroy();
+		m_computeTimeline.reset();
+		vkDestroyCommandPool(m_vkDevice, m_vkComputeCommandPool, hostAllocator(MemorySubsystem::Commands));
+	}
+
+	if (m_vkParticleQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(m_vkDevice, m_vkParticleQueryPool, hostAllocator(MemorySubsystem::Sync));
+	}
+
+	vkDestroyPipeline(m_vkDevice, m_vkParticleSimulatePipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipeline(m_vkDevice, m_vkRadixHistogramPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipeline(m_vkDevice, m_vkRadixScanPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipeline(m_vkDevice, m_vkRadixScatterPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkParticleSimulatePipelineLayout, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkRadixSortPipelineLayout, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyDescriptorPool(m_vkDevice, m_vkParticleDescriptorPool, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkParticleSimulateDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkRadixSortDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkParticleDrawDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+
+	vkDestroyBuffer(m_vkDevice, m_vkSortHistogramBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkSortHistogramBufferMemory);
+	vkDestroyBuffer(m_vkDevice, m_vkSortScratchValueBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkSortScratchValueBufferMemory);
+	vkDestroyBuffer(m_vkDevice, m_vkSortScratchKeyBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkSortScratchKeyBufferMemory);
+
+	for (size_t i = 0; i < m_vkParticleBuffers.size(); ++i)
+	{
+		vkDestroyBuffer(m_vkDevice, m_vkSortValueBuffers[i], hostAllocator(MemorySubsystem::Buffers));
+		freeDeviceMemory(m_vkSortValueBufferMemories[i]);
+		vkDestroyBuffer(m_vkDevice, m_vkSortKeyBuffers[i], hostAllocator(MemorySubsystem::Buffers));
+		freeDeviceMemory(m_vkSortKeyBufferMemories[i]);
+		vkDestroyBuffer(m_vkDevice, m_vkParticleBuffers[i], hostAllocator(MemorySubsystem::Buffers));
+		freeDeviceMemory(m_vkParticleBufferMemories[i]);
+	}
+}
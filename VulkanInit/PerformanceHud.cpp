@@ -0,0 +1,523 @@
+#include "Engine.h"
+#include "VulkanUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	const float HUD_TEXT_SCALE = 2.0f;
+	const float HUD_LINE_HEIGHT = (HudBatch::GLYPH_HEIGHT + 2) * HUD_TEXT_SCALE;
+	const float HUD_MARGIN = 8.0f;
+	const float HUD_PADDING = 8.0f;
+	const float HUD_GRAPH_BAR_WIDTH = 2.0f;
+	const float HUD_GRAPH_HEIGHT = 48.0f;
+	const float HUD_GRAPH_RANGE_MS = 33.3f;
+	const float HUD_TARGET_FRAME_MS = 16.7f;
+	const float HUD_SPLIT_BAR_HEIGHT = 4.0f;
+	const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+}
+
+void Engine::createHudRenderPass()
+{
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format = m_vkSwapchainImageFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = m_vkPresentLayout;
+	colorAttachment.finalLayout = m_vkPresentLayout;
+
+	VkAttachmentReference colorAttachmentRef = {};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+
+	// The overlay blends over whatever the main pass wrote to the image.
+	VkSubpassDependency dependency = {};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassCreateInfo.attachmentCount = 1;
+	renderPassCreateInfo.pAttachments = &colorAttachment;
+	renderPassCreateInfo.subpassCount = 1;
+	renderPassCreateInfo.pSubpasses = &subpass;
+	renderPassCreateInfo.dependencyCount = 1;
+	renderPassCreateInfo.pDependencies = &dependency;
+
+	VkResult result = vkCreateRenderPass(m_vkDevice, &renderPassCreateInfo, hostAllocator(MemorySubsystem::Hud), &m_vkHudRenderPass);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create HUD render pass.");
+	}
+}
+
+void Engine::createHudFramebuffers()
+{
+	m_vkHudFramebuffers.resize(m_vkSwapchainImageViews.size());
+
+	VkFramebufferCreateInfo framebufferCreateInfo = {};
+	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferCreateInfo.renderPass = m_vkHudRenderPass;
+	framebufferCreateInfo.attachmentCount = 1;
+	framebufferCreateInfo.width = m_vkSwapchainExtent.width;
+	framebufferCreateInfo.height = m_vkSwapchainExtent.height;
+	framebufferCreateInfo.layers = 1;
+
+	for (size_t i = 0; i < m_vkSwapchainImageViews.size(); ++i)
+	{
+		framebufferCreateInfo.pAttachments = &m_vkSwapchainImageViews[i];
+
+		VkResult result = vkCreateFramebuffer(m_vkDevice, &framebufferCreateInfo, hostAllocator(MemorySubsystem::Hud), &m_vkHudFramebuffers[i]);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create HUD frame buffer.");
+		}
+	}
+}
+
+void Engine::createHudDescriptorSetLayout()
+{
+	m_vkHudDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, hostAllocator(MemorySubsystem::Hud), {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+	});
+}
+
+void Engine::createHudResources()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	createHudFontAtlas();
+
+	VkDeviceSize vertexBufferSize = sizeof(HudVertex) * HUD_MAX_VERTICES * MAX_FRAMES_IN_FLIGHT;
+
+	createBuffer(vertexBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_vkHudVertexBuffer, m_vkHudVertexBufferMemory, MemorySubsystem::Hud);
+
+	void* data;
+	vkMapMemory(m_vkDevice, m_vkHudVertexBufferMemory, 0, vertexBufferSize, 0, &data);
+	m_hudVertices = static_cast<HudVertex*>(data);
+
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[0].descriptorCount = 1;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = 2;
+	poolCreateInfo.pPoolSizes = poolSizes;
+
+	VkResult result = vkCreateDescriptorPool(m_vkDevice, &poolCreateInfo, hostAllocator(MemorySubsystem::Hud), &m_vkHudDescriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool.");
+	}
+
+	VkDescriptorSetAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = m_vkHudDescriptorPool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &m_vkHudDescriptorSetLayout;
+
+	result = vkAllocateDescriptorSets(m_vkDevice, &allocateInfo, &m_vkHudDescriptorSet);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor sets.");
+	}
+
+	VkDescriptorBufferInfo vertexInfo = { m_vkHudVertexBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorImageInfo fontInfo = { m_vkHudFontSampler, m_vkHudFontImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+	VkWriteDescriptorSet writes[] = {
+		bufferWrite(m_vkHudDescriptorSet, 0, &vertexInfo),
+		imageWrite(m_vkHudDescriptorSet, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &fontInfo)
+	};
+
+	vkUpdateDescriptorSets(m_vkDevice, 2, writes, 0, nullptr);
+
+	m_vkFrameQueryPool = VK_NULL_HANDLE;
+
+	if (properties.limits.timestampComputeAndGraphics)
+	{
+		VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = MAX_FRAMES_IN_FLIGHT * FRAME_TIMESTAMP_COUNT;
+
+		result = vkCreateQueryPool(m_vkDevice, &queryPoolCreateInfo, hostAllocator(MemorySubsystem::Hud), &m_vkFrameQueryPool);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create query pool.");
+		}
+	}
+
+	m_hudVisible = m_settings.hud;
+	m_hudFrameTimes.assign(HUD_HISTORY_SIZE, 0.0f);
+	m_pendingFrameStats.assign(MAX_FRAMES_IN_FLIGHT, FrameStats());
+	m_frameStats = {};
+}
+
+void Engine::createHudFontAtlas()
+{
+	HudFontAtlas atlas = HudBatch::buildFontAtlas();
+	VkDeviceSize atlasSize = atlas.pixels.size();
+
+	createImage(atlas.width, atlas.height, 1, VK_FORMAT_R8_UNORM,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		m_vkHudFontImage, m_vkHudFontImageMemory, MemorySubsystem::Hud);
+
+	m_vkHudFontImageView = createImageView(m_vkHudFontImage, VK_FORMAT_R8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1);
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(atlasSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer, stagingBufferMemory, MemorySubsystem::Hud);
+
+	void* data;
+	vkMapMemory(m_vkDevice, stagingBufferMemory, 0, atlasSize, 0, &data);
+	memcpy(data, atlas.pixels.data(), static_cast<size_t>(atlasSize));
+	vkUnmapMemory(m_vkDevice, stagingBufferMemory);
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = m_vkHudFontImage;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { atlas.width, atlas.height, 1 };
+
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, m_vkHudFontImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(m_vkDevice, stagingBuffer, hostAllocator(MemorySubsystem::Hud));
+	freeDeviceMemory(stagingBufferMemory);
+
+	VkSamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = 0.0f;
+
+	VkResult result = vkCreateSampler(m_vkDevice, &samplerCreateInfo, hostAllocator(MemorySubsystem::Hud), &m_vkHudFontSampler);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create HUD font sampler.");
+	}
+}
+
+void Engine::createHudPipeline()
+{
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_vkHudDescriptorSetLayout;
+
+	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, hostAllocator(MemorySubsystem::Hud), &m_vkHudPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+
+	GraphicsPipelineState hudState;
+	hudState.vertexShader = "hud_vertex.spv";
+	hudState.fragmentShader = "hud_fragment.spv";
+	hudState.cullMode = VK_CULL_MODE_NONE;
+	hudState.blendEnable = true;
+
+	m_vkHudPipeline = buildGraphicsPipeline(hudState, m_vkHudPipelineLayout, m_vkHudRenderPass);
+}
+
+double Engine::measureFrameTime()
+{
+	std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+	double frameTimeMs = 0.0;
+
+	if (m_frameNumber > 0)
+	{
+		frameTimeMs = std::chrono::duration<double, std::milli>(frameStart - m_lastFrameStart).count();
+	}
+
+	m_lastFrameStart = frameStart;
+	return frameTimeMs;
+}
+
+void Engine::writeFrameTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t query)
+{
+	if (m_vkFrameQueryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	uint32_t firstQuery = static_cast<uint32_t>(m_currentFrame) * FRAME_TIMESTAMP_COUNT;
+
+	if (query == 0)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_vkFrameQueryPool, firstQuery, FRAME_TIMESTAMP_COUNT);
+	}
+
+	vkCmdWriteTimestamp(commandBuffer, stage, m_vkFrameQueryPool, firstQuery + query);
+}
+
+HudReadout Engine::readHud()
+{
+	if (m_frameNumber % MEMORY_STATS_INTERVAL == 0 || m_hudMemoryStats.subsystems.empty())
+	{
+		m_hudMemoryStats = m_memoryTracker->getStats();
+	}
+
+	// The overlay shows the newest frame whose GPU work has finished.
+	HudReadout hud = {};
+	hud.frameTimeMs = m_frameStats.frameTimeMs;
+	hud.cpuTimeMs = m_frameStats.cpuTimeMs;
+	hud.gpuTimeMs = m_frameStats.gpuTimeMs;
+	hud.hudCpuTimeMs = m_frameStats.hudCpuTimeMs;
+	hud.hudGpuTimeMs = m_frameStats.hudGpuTimeMs;
+	hud.drawCount = m_frameStats.drawCount;
+
+	for (const MemorySubsystemStats& subsystem : m_hudMemoryStats.subsystems)
+	{
+		hud.deviceBytes += subsystem.deviceBytes;
+		hud.hostBytes += subsystem.hostBytes;
+	}
+
+	for (const MemoryHeapStats& heap : m_hudMemoryStats.heaps)
+	{
+		if (heap.deviceLocal)
+		{
+			hud.heapUsage += heap.usage;
+			hud.heapBudget += heap.budget;
+		}
+	}
+
+	return hud;
+}
+
+void Engine::buildHudOverlay(HudBatch& batch, const HudReadout& hud)
+{
+	float graphWidth = HUD_HISTORY_SIZE * HUD_GRAPH_BAR_WIDTH;
+	float left = HUD_MARGIN + HUD_PADDING;
+	float y = HUD_MARGIN + HUD_PADDING;
+	float panelHeight = HUD_PADDING * 2 + HUD_LINE_HEIGHT * 6 + HUD_SPLIT_BAR_HEIGHT * 3 + HUD_GRAPH_HEIGHT;
+
+	uint32_t textColor = HudBatch::packColor(1.0f, 1.0f, 1.0f, 1.0f);
+	uint32_t cpuColor = HudBatch::packColor(0.3f, 0.7f, 1.0f, 1.0f);
+	uint32_t gpuColor = HudBatch::packColor(1.0f, 0.6f, 0.2f, 1.0f);
+
+	batch.addRect(HUD_MARGIN, HUD_MARGIN, graphWidth + HUD_PADDING * 2, panelHeight, HudBatch::packColor(0.0f, 0.0f, 0.0f, 0.6f));
+
+	char line[96];
+	double fps = hud.frameTimeMs > 0.0 ? 1000.0 / hud.frameTimeMs : 0.0;
+
+	snprintf(line, sizeof(line), "FRAME %.2f MS  %.0f FPS", hud.frameTimeMs, fps);
+	batch.addText(left, y, HUD_TEXT_SCALE, textColor, line);
+	y += HUD_LINE_HEIGHT;
+
+	snprintf(line, sizeof(line), "CPU %.2f MS", hud.cpuTimeMs);
+	float x = batch.addText(left, y, HUD_TEXT_SCALE, cpuColor, line);
+	snprintf(line, sizeof(line), "  GPU %.2f MS", hud.gpuTimeMs);
+	batch.addText(x, y, HUD_TEXT_SCALE, gpuColor, line);
+	y += HUD_LINE_HEIGHT;
+
+	// CPU and GPU time as fractions of the frame interval.
+	if (hud.frameTimeMs > 0.0)
+	{
+		float cpuFraction = static_cast<float>(std::min(hud.cpuTimeMs / hud.frameTimeMs, 1.0));
+		float gpuFraction = static_cast<float>(std::min(hud.gpuTimeMs / hud.frameTimeMs, 1.0));
+
+		batch.addRect(left, y, graphWidth * cpuFraction, HUD_SPLIT_BAR_HEIGHT, cpuColor);
+		batch.addRect(left, y + HUD_SPLIT_BAR_HEIGHT, graphWidth * gpuFraction, HUD_SPLIT_BAR_HEIGHT, gpuColor);
+	}
+
+	y += HUD_SPLIT_BAR_HEIGHT * 3;
+
+	if (m_settings.dynamicResolution)
+	{
+		snprintf(line, sizeof(line), "DRAWS %u  SCALE %.0f%%", hud.drawCount, m_renderScale * 100.0f);
+	}
+	else
+	{
+		snprintf(line, sizeof(line), "DRAWS %u", hud.drawCount);
+	}
+
+	batch.addText(left, y, HUD_TEXT_SCALE, textColor, line);
+	y += HUD_LINE_HEIGHT;
+
+	snprintf(line, sizeof(line), "VRAM %.0f / %.0f MB", hud.heapUsage / BYTES_PER_MEGABYTE, hud.heapBudget / BYTES_PER_MEGABYTE);
+	batch.addText(left, y, HUD_TEXT_SCALE, textColor, line);
+	y += HUD_LINE_HEIGHT;
+
+	snprintf(line, sizeof(line), "ALLOC %.1f MB  HOST %.1f MB", hud.deviceBytes / BYTES_PER_MEGABYTE, hud.hostBytes / BYTES_PER_MEGABYTE);
+	batch.addText(left, y, HUD_TEXT_SCALE, textColor, line);
+	y += HUD_LINE_HEIGHT;
+
+	snprintf(line, sizeof(line), "HUD CPU %.3f  GPU %.3f MS", hud.hudCpuTimeMs, hud.hudGpuTimeMs);
+	batch.addText(left, y, HUD_TEXT_SCALE, textColor, line);
+	y += HUD_LINE_HEIGHT;
+
+	// Frame time graph, oldest sample on the left, scaled to two 60 Hz frames.
+	float graphBottom = y + HUD_GRAPH_HEIGHT;
+	float targetY = graphBottom - HUD_GRAPH_HEIGHT * (HUD_TARGET_FRAME_MS / HUD_GRAPH_RANGE_MS);
+	batch.addRect(left, targetY, graphWidth, 1.0f, HudBatch::packColor(1.0f, 1.0f, 1.0f, 0.3f));
+
+	for (uint32_t i = 0; i < HUD_HISTORY_SIZE; ++i)
+	{
+		float frameTime = m_hudFrameTimes[(m_frameNumber + 1 + i) % HUD_HISTORY_SIZE];
+		float height = HUD_GRAPH_HEIGHT * std::min(frameTime / HUD_GRAPH_RANGE_MS, 1.0f);
+
+		uint32_t color = frameTime <= HUD_TARGET_FRAME_MS ? HudBatch::packColor(0.3f, 0.9f, 0.3f, 1.0f) :
+			frameTime <= HUD_GRAPH_RANGE_MS ? HudBatch::packColor(1.0f, 0.85f, 0.2f, 1.0f) :
+			HudBatch::packColor(1.0f, 0.25f, 0.2f, 1.0f);
+
+		batch.addRect(left + i * HUD_GRAPH_BAR_WIDTH, graphBottom - height, HUD_GRAPH_BAR_WIDTH, height, color);
+	}
+}
+
+void Engine::recordHud(VkCommandBuffer commandBuffer, uint32_t imageIndex, const HudReadout& hud)
+{
+	m_hudFrameTimes[m_frameNumber % HUD_HISTORY_SIZE] = static_cast<float>(hud.frameTimeMs);
+
+	// Both overlay timestamps wait for all earlier work, so their difference
+	// is the cost of the overlay pass alone.
+	writeFrameTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+
+	if (m_hudVisible)
+	{
+		std::chrono::steady_clock::time_point recordStart = std::chrono::steady_clock::now();
+
+		uint32_t firstVertex = static_cast<uint32_t>(m_currentFrame) * HUD_MAX_VERTICES;
+		HudBatch batch(m_hudVertices + firstVertex, HUD_MAX_VERTICES, m_vkSwapchainExtent.width, m_vkSwapchainExtent.height);
+
+		++m_pendingFrameStats[m_currentFrame].drawCount;
+		buildHudOverlay(batch, hud);
+
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = m_vkHudRenderPass;
+		renderPassInfo.framebuffer = m_vkHudFramebuffers[imageIndex];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = m_vkSwapchainExtent;
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vkHudPipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vkHudPipelineLayout,
+			0, 1, &m_vkHudDescriptorSet, 0, nullptr);
+		vkCmdDraw(commandBuffer, batch.getVertexCount(), 1, firstVertex, 0);
+		vkCmdEndRenderPass(commandBuffer);
+
+		m_pendingFrameStats[m_currentFrame].hudCpuTimeMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - recordStart).count();
+	}
+
+	writeFrameTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2);
+}
+
+void Engine::collectFrameStats(uint32_t frameSlot)
+{
+	FrameStats& stats = m_pendingFrameStats[frameSlot];
+
+	if (m_vkFrameQueryPool != VK_NULL_HANDLE)
+	{
+		uint64_t timestamps[4];
+		VkResult result = vkGetQueryPoolResults(m_vkDevice, m_vkFrameQueryPool,
+			frameSlot * FRAME_TIMESTAMP_COUNT, FRAME_TIMESTAMP_COUNT,
+			sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+		if (result == VK_SUCCESS)
+		{
+			double nanosecondsToMilliseconds = static_cast<double>(m_timestampPeriod) / 1000000.0;
+
+			stats.gpuTimeMs = static_cast<double>(timestamps[3] - timestamps[0]) * nanosecondsToMilliseconds;
+			stats.hudGpuTimeMs = static_cast<double>(timestamps[2] - timestamps[1]) * nanosecondsToMilliseconds;
+		}
+	}
+
+	m_frameStats = stats;
+
+	for (const FrameStatsCallback& callback : m_frameStatsCallbacks)
+	{
+		callback(m_frameStats);
+	}
+}
+
+void Engine::destroyHudResources()
+{
+	if (m_vkFrameQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(m_vkDevice, m_vkFrameQueryPool, hostAllocator(MemorySubsystem::Hud));
+	}
+
+	vkDestroyPipeline(m_vkDevice, m_vkHudPipeline, hostAllocator(MemorySubsystem::Pipelines));
+	vkDestroyPipelineLayout(m_vkDevice, m_vkHudPipelineLayout, hostAllocator(MemorySubsystem::Hud));
+	vkDestroyDescriptorPool(m_vkDevice, m_vkHudDescriptorPool, hostAllocator(MemorySubsystem::Hud));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkHudDescriptorSetLayout, hostAllocator(MemorySubsystem::Hud));
+
+	vkDestroySampler(m_vkDevice, m_vkHudFontSampler, hostAllocator(MemorySubsystem::Hud));
+	vkDestroyImageView(m_vkDevice, m_vkHudFontImageView, hostAllocator(MemorySubsystem::RenderTargets));
+	vkDestroyImage(m_vkDevice, m_vkHudFontImage, hostAllocator(MemorySubsystem::Hud));
+	freeDeviceMemory(m_vkHudFontImageMemory);
+
+	vkDestroyBuffer(m_vkDevice, m_vkHudVertexBuffer, hostAllocator(MemorySubsystem::Hud));
+	freeDeviceMemory(m_vkHudVertexBufferMemory);
+
+	for (VkFramebuffer framebuffer : m_vkHudFramebuffers)
+	{
+		vkDestroyFramebuffer(m_vkDevice, framebuffer, hostAllocator(MemorySubsystem::Hud));
+	}
+
+	vkDestroyRenderPass(m_vkDevice, m_vkHudRenderPass, hostAllocator(MemorySubsystem::Hud));
+}
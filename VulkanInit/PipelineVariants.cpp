@@ -0,0 +1,227 @@
+#include "PipelineVariants.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace
+{
+	const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	const uint64_t FNV_PRIME = 1099511628211ull;
+
+	void hashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+	}
+
+	template <typename T>
+	void hashValue(uint64_t& hash, const T& value)
+	{
+		hashBytes(hash, &value, sizeof(value));
+	}
+}
+
+bool GraphicsPipelineState::operator==(const GraphicsPipelineState& other) const
+{
+	return vertexShader == other.vertexShader &&
+		fragmentShader == other.fragmentShader &&
+		topology == other.topology &&
+		cullMode == other.cullMode &&
+		frontFace == other.frontFace &&
+		depthTest == other.depthTest &&
+		blendEnable == other.blendEnable &&
+		dynamicViewport == other.dynamicViewport &&
+		vertexStride == other.vertexStride &&
+		specializationConstants == other.specializationConstants;
+}
+
+size_t GraphicsPipelineStateHash::operator()(const GraphicsPipelineState& state) const
+{
+	uint64_t hash = FNV_OFFSET_BASIS;
+
+	hashBytes(hash, state.vertexShader.data(), state.vertexShader.size());
+	hashBytes(hash, state.fragmentShader.data(), state.fragmentShader.size());
+	hashValue(hash, state.topology);
+	hashValue(hash, state.cullMode);
+	hashValue(hash, state.frontFace);
+	hashValue(hash, state.depthTest);
+	hashValue(hash, state.blendEnable);
+	hashValue(hash, state.dynamicViewport);
+	hashValue(hash, state.vertexStride);
+	hashBytes(hash, state.specializationConstants.data(), state.specializationConstants.size() * sizeof(uint32_t));
+
+	return static_cast<size_t>(hash);
+}
+
+PipelineVariants::PipelineVariants(VkDevice device, const VkAllocationCallbacks* allocator, ThreadPool& threadPool,
+	Builder builder)
+	: m_vkDevice(device),
+	m_vkAllocator(allocator),
+	m_threadPool(threadPool),
+	m_builder(builder),
+	m_stats()
+{
+}
+
+VkPipeline PipelineVariants::build(const GraphicsPipelineState& state)
+{
+	auto start = std::chrono::steady_clock::now();
+	VkPipeline pipeline = m_builder(state);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_stats.compiled;
+	m_stats.totalCompileTimeMs += elapsed.count();
+	m_stats.maxCompileTimeMs = std::max(m_stats.maxCompileTimeMs, elapsed.count());
+
+	return pipeline;
+}
+
+void PipelineVariants::finish(Variant* variant, VkPipeline pipeline, bool failed, bool background)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		variant->pipeline = pipeline;
+		variant->pending = false;
+		variant->failed = failed;
+
+		if (background)
+		{
+			--m_stats.pending;
+		}
+
+		if (failed)
+		{
+			++m_stats.failed;
+		}
+	}
+
+	m_built.notify_all();
+}
+
+void PipelineVariants::buildInBackground(const GraphicsPipelineState& state, Variant* variant)
+{
+	++m_stats.pending;
+	variant->pending = true;
+	variant->failed = false;
+
+	m_threadPool.submit([this, state, variant]()
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		bool failed = false;
+
+		try
+		{
+			pipeline = build(state);
+		}
+		catch (const std::exception&)
+		{
+			failed = true;
+		}
+
+		finish(variant, pipeline, failed, true);
+	});
+}
+
+VkPipeline PipelineVariants::compile(const GraphicsPipelineState& state)
+{
+	Variant* variant;
+
+	{
+		// A variant already being built elsewhere is waited for rather than
+		// built twice, which would leak one of the two pipelines.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		std::unique_ptr<Variant>& slot = m_variants[state];
+
+		if (!slot)
+		{
+			slot.reset(new Variant());
+			slot->pipeline = VK_NULL_HANDLE;
+			slot->pending = false;
+			slot->failed = false;
+		}
+
+		variant = slot.get();
+		m_built.wait(lock, [variant]() { return !variant->pending; });
+
+		if (variant->pipeline != VK_NULL_HANDLE)
+		{
+			return variant->pipeline;
+		}
+
+		variant->pending = true;
+	}
+
+	VkPipeline pipeline;
+
+	try
+	{
+		pipeline = build(state);
+	}
+	catch (const std::exception&)
+	{
+		finish(variant, VK_NULL_HANDLE, true, false);
+		throw;
+	}
+
+	finish(variant, pipeline, false, false);
+
+	return pipeline;
+}
+
+VkPipeline PipelineVariants::request(const GraphicsPipelineState& state, VkPipeline fallback)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_stats.requests;
+
+	std::unique_ptr<Variant>& slot = m_variants[state];
+
+	if (slot && (slot->pipeline != VK_NULL_HANDLE || slot->pending))
+	{
+		return slot->pipeline != VK_NULL_HANDLE ? slot->pipeline : fallback;
+	}
+
+	// Missing and previously failed variants are both misses, so a failed
+	// build is retried instead of falling back for good.
+	++m_stats.misses;
+
+	if (!slot)
+	{
+		slot.reset(new Variant());
+		slot->pipeline = VK_NULL_HANDLE;
+	}
+
+	buildInBackground(state, slot.get());
+
+	return fallback;
+}
+
+PipelineVariantStats PipelineVariants::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+void PipelineVariants::destroy()
+{
+	m_threadPool.waitIdle();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (auto& variant : m_variants)
+	{
+		VkPipeline pipeline = variant.second->pipeline;
+
+		if (pipeline != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(m_vkDevice, pipeline, m_vkAllocator);
+		}
+	}
+
+	m_variants.clear();
+}
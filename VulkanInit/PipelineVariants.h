@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vulkan.h>
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct GraphicsPipelineState
+{
+	std::string vertexShader;
+	std::string fragmentShader;
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+	bool depthTest = false;
+	bool blendEnable = false;
+	bool dynamicViewport = false;
+	uint32_t vertexStride = 0;
+	std::vector<uint32_t> specializationConstants;
+
+	bool operator==(const GraphicsPipelineState& other) const;
+};
+
+struct GraphicsPipelineStateHash
+{
+	size_t operator()(const GraphicsPipelineState& state) const;
+};
+
+struct PipelineVariantStats
+{
+	uint64_t requests;
+	uint64_t misses;
+	uint32_t compiled;
+	uint32_t pending;
+	uint32_t failed;
+	double totalCompileTimeMs;
+	double maxCompileTimeMs;
+};
+
+// Owns every pipeline built from a GraphicsPipelineState. Missing variants are
+// compiled on the thread pool while request() keeps returning the fallback, so
+// the render thread never waits for the driver compiler.
+class PipelineVariants
+{
+public:
+	typedef std::function<VkPipeline(const GraphicsPipelineState&)> Builder;
+
+private:
+	// Guarded by m_mutex. A pending variant is being built by some thread,
+	// and m_built is notified once it finishes.
+	struct Variant
+	{
+		VkPipeline pipeline;
+		bool pending;
+		bool failed;
+	};
+
+	VkDevice m_vkDevice;
+	const VkAllocationCallbacks* m_vkAllocator;
+	ThreadPool& m_threadPool;
+	Builder m_builder;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_built;
+	std::unordered_map<GraphicsPipelineState, std::unique_ptr<Variant>, GraphicsPipelineStateHash> m_variants;
+	PipelineVariantStats m_stats;
+
+	VkPipeline build(const GraphicsPipelineState& state);
+	void finish(Variant* variant, VkPipeline pipeline, bool failed, bool background);
+	// Called with m_mutex held.
+	void buildInBackground(const GraphicsPipelineState& state, Variant* variant);
+
+public:
+	PipelineVariants(VkDevice device, const VkAllocationCallbacks* allocator, ThreadPool& threadPool, Builder builder);
+
+	PipelineVariants(const PipelineVariants&) = delete;
+	PipelineVariants& operator=(const PipelineVariants&) = delete;
+
+	VkPipeline compile(const GraphicsPipelineState& state);
+	VkPipeline request(const GraphicsPipelineState& state, VkPipeline fallback);
+	PipelineVariantStats getStats() const;
+	void destroy();
+};
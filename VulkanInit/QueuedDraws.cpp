@@ -0,0 +1,199 @@
+#include "Engine.h"
+#include "VulkanUtils.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	const uint32_t QUEUED_PIPELINE_COUNT = 4;
+	const uint32_t QUEUED_MATERIAL_COUNT = 64;
+	const uint32_t QUEUED_MESH_COUNT = 8;
+	const uint32_t MAIN_PASS = 0;
+
+	// A regular polygon of unit radius as a triangle list; mesh i has i + 3
+	// sides, so every mesh has a different vertex count.
+	std::vector<glm::vec2> polygonMesh(uint32_t sides)
+	{
+		std::vector<glm::vec2> vertices;
+		float step = 6.28318530718f / static_cast<float>(sides);
+
+		for (uint32_t i = 0; i < sides; ++i)
+		{
+			vertices.push_back(glm::vec2(0.0f, 0.0f));
+			vertices.push_back(glm::vec2(std::cos(step * i), std::sin(step * i)));
+			vertices.push_back(glm::vec2(std::cos(step * (i + 1)), std::sin(step * (i + 1))));
+		}
+
+		return vertices;
+	}
+}
+
+void Engine::createQueuedDrawDescriptorSetLayout()
+{
+	m_vkQueuedDrawDescriptorSetLayout = createDescriptorSetLayout(m_vkDevice, hostAllocator(MemorySubsystem::Descriptors), {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+	});
+}
+
+void Engine::createQueuedDrawResources()
+{
+	m_sceneDraws = generateSceneDraws(m_settings.queuedDraws, QUEUED_PIPELINE_COUNT, QUEUED_MATERIAL_COUNT, QUEUED_MESH_COUNT);
+	streamUpload(CommandStreamUpload::QueuedDraws, m_sceneDraws.data(), sizeof(SceneDraw) * m_sceneDraws.size());
+
+	std::vector<glm::vec2> vertices;
+	m_queuedDrawMeshOffsets.resize(QUEUED_MESH_COUNT);
+	m_queuedDrawMeshVertexCounts.resize(QUEUED_MESH_COUNT);
+
+	for (uint32_t i = 0; i < QUEUED_MESH_COUNT; ++i)
+	{
+		std::vector<glm::vec2> mesh = polygonMesh(i + 3);
+
+		m_queuedDrawMeshOffsets[i] = sizeof(glm::vec2) * vertices.size();
+		m_queuedDrawMeshVertexCounts[i] = static_cast<uint32_t>(mesh.size());
+		vertices.insert(vertices.end(), mesh.begin(), mesh.end());
+	}
+
+	VkDeviceSize meshBufferSize = sizeof(glm::vec2) * vertices.size();
+	createBuffer(meshBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_vkQueuedDrawMeshBuffer, m_vkQueuedDrawMeshBufferMemory, MemorySubsystem::Buffers);
+
+	void* data;
+	vkMapMemory(m_vkDevice, m_vkQueuedDrawMeshBufferMemory, 0, meshBufferSize, 0, &data);
+	memcpy(data, vertices.data(), static_cast<size_t>(meshBufferSize));
+	vkUnmapMemory(m_vkDevice, m_vkQueuedDrawMeshBufferMemory);
+
+	// Every material is its own descriptor set over a slice of one uniform
+	// buffer, so switching materials is a real descriptor set bind.
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+
+	VkDeviceSize alignment = properties.limits.minUniformBufferOffsetAlignment;
+	m_queuedDrawMaterialStride = (sizeof(glm::vec4) + alignment - 1) / alignment * alignment;
+
+	VkDeviceSize materialBufferSize = m_queuedDrawMaterialStride * QUEUED_MATERIAL_COUNT;
+	createBuffer(materialBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_vkQueuedDrawMaterialBuffer, m_vkQueuedDrawMaterialBufferMemory, MemorySubsystem::Buffers);
+
+	vkMapMemory(m_vkDevice, m_vkQueuedDrawMaterialBufferMemory, 0, materialBufferSize, 0, &data);
+
+	for (uint32_t i = 0; i < QUEUED_MATERIAL_COUNT; ++i)
+	{
+		float hue = static_cast<float>(i) / QUEUED_MATERIAL_COUNT * 6.28318530718f;
+		glm::vec4 color(
+			0.6f + 0.4f * std::cos(hue),
+			0.6f + 0.4f * std::cos(hue + 2.09439510239f),
+			0.6f + 0.4f * std::cos(hue + 4.18879020479f),
+			1.0f);
+
+		memcpy(static_cast<uint8_t*>(data) + m_queuedDrawMaterialStride * i, &color, sizeof(glm::vec4));
+	}
+
+	vkUnmapMemory(m_vkDevice, m_vkQueuedDrawMaterialBufferMemory);
+
+	createQueuedDrawDescriptors();
+}
+
+void Engine::createQueuedDrawDescriptors()
+{
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSize.descriptorCount = QUEUED_MATERIAL_COUNT;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = QUEUED_MATERIAL_COUNT;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkResult result = vkCreateDescriptorPool(m_vkDevice, &poolCreateInfo, hostAllocator(MemorySubsystem::Descriptors), &m_vkQueuedDrawDescriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool.");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts(QUEUED_MATERIAL_COUNT, m_vkQueuedDrawDescriptorSetLayout);
+	m_vkQueuedDrawMaterialSets.resize(QUEUED_MATERIAL_COUNT);
+
+	VkDescriptorSetAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = m_vkQueuedDrawDescriptorPool;
+	allocateInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+	allocateInfo.pSetLayouts = setLayouts.data();
+
+	result = vkAllocateDescriptorSets(m_vkDevice, &allocateInfo, m_vkQueuedDrawMaterialSets.data());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor sets.");
+	}
+
+	std::vector<VkDescriptorBufferInfo> materialInfos(QUEUED_MATERIAL_COUNT);
+	std::vector<VkWriteDescriptorSet> writes;
+
+	for (uint32_t i = 0; i < QUEUED_MATERIAL_COUNT; ++i)
+	{
+		materialInfos[i] = { m_vkQueuedDrawMaterialBuffer, m_queuedDrawMaterialStride * i, sizeof(glm::vec4) };
+
+		VkWriteDescriptorSet materialWrite = bufferWrite(m_vkQueuedDrawMaterialSets[i], 0, &materialInfos[i]);
+		materialWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes.push_back(materialWrite);
+	}
+
+	vkUpdateDescriptorSets(m_vkDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void Engine::createQueuedDrawPipelines()
+{
+	// The variants differ only in the fragment pattern, and are owned by the
+	// variant cache like every other graphics pipeline.
+	m_vkQueuedDrawPipelines.resize(QUEUED_PIPELINE_COUNT);
+
+	for (uint32_t i = 0; i < QUEUED_PIPELINE_COUNT; ++i)
+	{
+		GraphicsPipelineState state = m_pipelineState;
+		state.specializationConstants = { i };
+
+		m_vkQueuedDrawPipelines[i] = m_pipelineVariants->compile(state);
+	}
+}
+
+void Engine::sortQueuedDraws()
+{
+	m_renderQueue.clear();
+
+	for (const SceneDraw& sceneDraw : m_sceneDraws)
+	{
+		RenderDraw draw;
+		draw.pipeline = m_vkQueuedDrawPipelines[sceneDraw.pipeline];
+		draw.material = m_vkQueuedDrawMaterialSets[sceneDraw.material];
+		draw.mesh = m_vkQueuedDrawMeshBuffer;
+		draw.meshOffset = m_queuedDrawMeshOffsets[sceneDraw.mesh];
+		draw.vertexCount = m_queuedDrawMeshVertexCounts[sceneDraw.mesh];
+		memcpy(draw.pushConstants, &sceneDraw.rect, sizeof(draw.pushConstants));
+
+		m_renderQueue.submit(RenderQueue::makeKey(MAIN_PASS, sceneDraw.pipeline, sceneDraw.material, sceneDraw.mesh,
+			sceneDraw.depth), draw);
+	}
+
+	m_renderQueue.sort(m_settings.parallelSort ? m_threadPool.get() : nullptr);
+}
+
+void Engine::recordQueuedDraws(VkCommandBuffer commandBuffer)
+{
+	m_renderQueue.record(commandBuffer, m_vkPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, MAIN_PASS);
+
+	m_pendingFrameStats[m_currentFrame].drawCount += m_renderQueue.getStats().drawCount;
+}
+
+void Engine::destroyQueuedDrawResources()
+{
+	vkDestroyDescriptorPool(m_vkDevice, m_vkQueuedDrawDescriptorPool, hostAllocator(MemorySubsystem::Descriptors));
+	vkDestroyDescriptorSetLayout(m_vkDevice, m_vkQueuedDrawDescriptorSetLayout, hostAllocator(MemorySubsystem::Descriptors));
+
+	vkDestroyBuffer(m_vkDevice, m_vkQueuedDrawMaterialBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkQueuedDrawMaterialBufferMemory);
+	vkDestroyBuffer(m_vkDevice, m_vkQueuedDrawMeshBuffer, hostAllocator(MemorySubsystem::Buffers));
+	freeDeviceMemory(m_vkQueuedDrawMeshBufferMemory);
+}
@@ -0,0 +1,216 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	const uint32_t RADIX_BITS = 8;
+	const uint32_t RADIX = 1 << RADIX_BITS;
+	const uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+	const size_t PARALLEL_SORT_THRESHOLD = 32768;
+	const size_t MIN_SORT_CHUNK = 8192;
+
+	uint64_t packField(uint32_t value, uint32_t bits, uint32_t shift)
+	{
+		return (static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1)) << shift;
+	}
+}
+
+uint64_t RenderQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+	uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+	uint32_t quantizedDepth = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+
+	uint32_t meshShift = DEPTH_BITS;
+	uint32_t materialShift = meshShift + MESH_BITS;
+	uint32_t pipelineShift = materialShift + MATERIAL_BITS;
+	uint32_t passShift = pipelineShift + PIPELINE_BITS;
+
+	return packField(pass, PASS_BITS, passShift) |
+		packField(pipeline, PIPELINE_BITS, pipelineShift) |
+		packField(material, MATERIAL_BITS, materialShift) |
+		packField(mesh, MESH_BITS, meshShift) |
+		packField(quantizedDepth, DEPTH_BITS, 0);
+}
+
+RenderQueue::RenderQueue()
+	: m_stats()
+{
+}
+
+void RenderQueue::clear()
+{
+	m_keys.clear();
+	m_draws.clear();
+}
+
+void RenderQueue::submit(uint64_t key, const RenderDraw& draw)
+{
+	m_keys.push_back(key);
+	m_draws.push_back(draw);
+}
+
+void RenderQueue::sort(ThreadPool* threadPool)
+{
+	auto sortStart = std::chrono::steady_clock::now();
+
+	size_t count = m_keys.size();
+	m_order.resize(count);
+	m_scratchKeys.resize(count);
+	m_scratchOrder.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_order[i] = static_cast<uint32_t>(i);
+	}
+
+	size_t chunkCount = 1;
+	if (threadPool != nullptr && count >= PARALLEL_SORT_THRESHOLD)
+	{
+		chunkCount = std::min(threadPool->getWorkerCount() + 1, count / MIN_SORT_CHUNK);
+	}
+
+	size_t chunkSize = (count + chunkCount - 1) / std::max<size_t>(chunkCount, 1);
+	m_histograms.resize(chunkCount * RADIX);
+
+	auto forEachChunk = [&](const std::function<void(size_t)>& task)
+	{
+		if (chunkCount > 1)
+		{
+			threadPool->parallelFor(chunkCount, task);
+		}
+		else
+		{
+			task(0);
+		}
+	};
+
+	// Least significant digit first: every pass is a stable counting sort on
+	// one byte of the key. Each chunk counts its own digits, the counts are
+	// turned into per-chunk output offsets, and each chunk scatters its keys,
+	// which keeps the parallel sort stable. Passes where every key shares
+	// the digit are skipped, which is most of them when few passes, pipelines
+	// or materials are in use.
+	for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+	{
+		uint32_t shift = pass * RADIX_BITS;
+
+		forEachChunk([&](size_t chunk)
+		{
+			uint32_t* histogram = &m_histograms[chunk * RADIX];
+			std::fill(histogram, histogram + RADIX, 0);
+
+			size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (size_t i = chunk * chunkSize; i < end; ++i)
+			{
+				++histogram[(m_keys[i] >> shift) & (RADIX - 1)];
+			}
+		});
+
+		bool uniformDigit = false;
+		uint32_t offset = 0;
+
+		for (uint32_t digit = 0; digit < RADIX && !uniformDigit; ++digit)
+		{
+			uint32_t digitTotal = 0;
+
+			for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+			{
+				uint32_t& slot = m_histograms[chunk * RADIX + digit];
+				uint32_t bucketSize = slot;
+				slot = offset;
+				offset += bucketSize;
+				digitTotal += bucketSize;
+			}
+
+			uniformDigit = digitTotal == count;
+		}
+
+		if (uniformDigit)
+		{
+			continue;
+		}
+
+		forEachChunk([&](size_t chunk)
+		{
+			uint32_t* offsets = &m_histograms[chunk * RADIX];
+
+			size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (size_t i = chunk * chunkSize; i < end; ++i)
+			{
+				uint32_t destination = offsets[(m_keys[i] >> shift) & (RADIX - 1)]++;
+				m_scratchKeys[destination] = m_keys[i];
+				m_scratchOrder[destination] = m_order[i];
+			}
+		});
+
+		m_keys.swap(m_scratchKeys);
+		m_order.swap(m_scratchOrder);
+	}
+
+	m_stats.sortThreads = static_cast<uint32_t>(chunkCount);
+	m_stats.sortTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+}
+
+void RenderQueue::record(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkShaderStageFlags pushConstantStages,
+	uint32_t pass)
+{
+	auto recordStart = std::chrono::steady_clock::now();
+
+	uint32_t passShift = 64 - PASS_BITS;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkDescriptorSet boundMaterial = VK_NULL_HANDLE;
+	VkBuffer boundMesh = VK_NULL_HANDLE;
+	VkDeviceSize boundMeshOffset = 0;
+
+	m_stats.drawCount = 0;
+	m_stats.pipelineBinds = 0;
+	m_stats.materialBinds = 0;
+	m_stats.meshBinds = 0;
+
+	for (size_t i = 0; i < m_keys.size(); ++i)
+	{
+		if ((m_keys[i] >> passShift) != pass)
+		{
+			continue;
+		}
+
+		const RenderDraw& draw = m_draws[m_order[i]];
+
+		if (draw.pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+			boundPipeline = draw.pipeline;
+			++m_stats.pipelineBinds;
+		}
+
+		if (draw.material != boundMaterial)
+		{
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+				0, 1, &draw.material, 0, nullptr);
+			boundMaterial = draw.material;
+			++m_stats.materialBinds;
+		}
+
+		if (draw.mesh != boundMesh || draw.meshOffset != boundMeshOffset)
+		{
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.mesh, &draw.meshOffset);
+			boundMesh = draw.mesh;
+			boundMeshOffset = draw.meshOffset;
+			++m_stats.meshBinds;
+		}
+
+		vkCmdPushConstants(commandBuffer, pipelineLayout, pushConstantStages, 0, sizeof(draw.pushConstants), draw.pushConstants);
+		vkCmdDraw(commandBuffer, draw.vertexCount, 1, 0, 0);
+		++m_stats.drawCount;
+	}
+
+	// Without sorting or filtering every draw would bind all three.
+	m_stats.eliminatedBinds = m_stats.drawCount * 3 - m_stats.pipelineBinds - m_stats.materialBinds - m_stats.meshBinds;
+	m_stats.recordTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+}
+
+const RenderQueueStats& RenderQueue::getStats() const
+{
+	return m_stats;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan.h>
+#include "ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+struct RenderDraw
+{
+	VkPipeline pipeline;
+	VkDescriptorSet material;
+	VkBuffer mesh;
+	VkDeviceSize meshOffset;
+	uint32_t vertexCount;
+	float pushConstants[4];
+};
+
+struct RenderQueueStats
+{
+	uint32_t drawCount;
+	uint32_t pipelineBinds;
+	uint32_t materialBinds;
+	uint32_t meshBinds;
+	uint32_t eliminatedBinds;
+	uint32_t sortThreads;
+	double sortTimeMs;
+	double recordTimeMs;
+};
+
+// Collects a frame's draws under 64-bit sort keys, radix sorts them and
+// records them with every bind that repeats the previous draw's state left
+// out. From the most significant bits down, a key holds the pass, pipeline,
+// material, mesh and quantized depth, so sorted draws change pipelines least
+// often and meshes most often. Large queues are sorted on the thread pool.
+class RenderQueue
+{
+private:
+	std::vector<uint64_t> m_keys;
+	std::vector<uint32_t> m_order;
+	std::vector<uint64_t> m_scratchKeys;
+	std::vector<uint32_t> m_scratchOrder;
+	std::vector<uint32_t> m_histograms;
+	std::vector<RenderDraw> m_draws;
+	RenderQueueStats m_stats;
+
+public:
+	static const uint32_t PASS_BITS = 4;
+	static const uint32_t PIPELINE_BITS = 12;
+	static const uint32_t MATERIAL_BITS = 12;
+	static const uint32_t MESH_BITS = 12;
+	static const uint32_t DEPTH_BITS = 24;
+
+	static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+	RenderQueue();
+
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	void clear();
+	void submit(uint64_t key, const RenderDraw& draw);
+	void sort(ThreadPool* threadPool);
+	void record(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkShaderStageFlags pushConstantStages,
+		uint32_t pass);
+
+	const RenderQueueStats& getStats() const;
+};
@@ -0,0 +1,161 @@
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include "Scene.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const float BLOCK_SPACING = 4.0f;
+	const float BLOCK_HALF_WIDTH = 1.5f;
+	const float LIGHT_FIELD_HALF_SIZE = 60.0f;
+	const float LIGHT_ORBIT_RADIUS = 3.0f;
+	const float GOLDEN_ANGLE = 2.39996323f;
+
+	uint32_t citySide(uint32_t instanceCount)
+	{
+		return static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(instanceCount))));
+	}
+}
+
+std::vector<SceneInstance> generateCityScene(uint32_t instanceCount)
+{
+	std::vector<SceneInstance> instances(instanceCount);
+
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> heightDistribution(1.0f, 8.0f);
+	std::uniform_real_distribution<float> colorDistribution(0.3f, 1.0f);
+
+	uint32_t side = citySide(instanceCount);
+
+	for (uint32_t i = 0; i < instanceCount; ++i)
+	{
+		float x = static_cast<float>(i % side) * BLOCK_SPACING;
+		float z = static_cast<float>(i / side) * BLOCK_SPACING;
+		float halfHeight = heightDistribution(generator) * 0.5f;
+
+		instances[i].center = glm::vec4(x, halfHeight, z, 0.0f);
+		instances[i].halfExtents = glm::vec4(BLOCK_HALF_WIDTH, halfHeight, BLOCK_HALF_WIDTH, 0.0f);
+		instances[i].color = glm::vec4(
+			colorDistribution(generator),
+			colorDistribution(generator),
+			colorDistribution(generator),
+			1.0f);
+	}
+
+	return instances;
+}
+
+SceneCamera createSceneCamera(uint32_t instanceCount, float aspectRatio)
+{
+	float extent = static_cast<float>(citySide(instanceCount)) * BLOCK_SPACING;
+
+	glm::vec3 eye(-BLOCK_SPACING, 2.0f, -BLOCK_SPACING);
+	glm::vec3 target(extent * 0.5f, 0.0f, extent * 0.5f);
+
+	SceneCamera camera;
+	camera.view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	camera.projection = glm::perspective(glm::radians(60.0f), aspectRatio, 0.1f, extent * 2.0f);
+	camera.projection[1][1] *= -1.0f;
+	camera.viewProjection = camera.projection * camera.view;
+
+	return camera;
+}
+
+SceneCamera createParticleCamera(float aspectRatio)
+{
+	glm::vec3 eye(0.0f, 10.0f, -28.0f);
+	glm::vec3 target(0.0f, 5.0f, 0.0f);
+
+	SceneCamera camera;
+	camera.view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	camera.projection = glm::perspective(glm::radians(60.0f), aspectRatio, 0.1f, 100.0f);
+	camera.projection[1][1] *= -1.0f;
+	camera.viewProjection = camera.projection * camera.view;
+
+	return camera;
+}
+
+std::vector<SceneLight> generateSceneLights(uint32_t lightCount)
+{
+	std::vector<SceneLight> lights(lightCount);
+
+	std::mt19937 generator(4321);
+	std::uniform_real_distribution<float> positionDistribution(-LIGHT_FIELD_HALF_SIZE, LIGHT_FIELD_HALF_SIZE);
+	std::uniform_real_distribution<float> heightDistribution(0.5f, 2.5f);
+	std::uniform_real_distribution<float> radiusDistribution(2.0f, 5.0f);
+	std::uniform_real_distribution<float> colorDistribution(0.2f, 1.0f);
+
+	for (SceneLight& light : lights)
+	{
+		light.positionRadius = glm::vec4(
+			positionDistribution(generator),
+			heightDistribution(generator),
+			positionDistribution(generator),
+			radiusDistribution(generator));
+		light.color = glm::vec4(
+			colorDistribution(generator),
+			colorDistribution(generator),
+			colorDistribution(generator),
+			1.0f);
+	}
+
+	return lights;
+}
+
+// Moves every light around a small circle about its generated position. The
+// speed and phase come from the light's index, so the result depends only on
+// the time and a replay animates exactly like its capture.
+void animateSceneLights(const std::vector<SceneLight>& lights, float time, SceneLight* output)
+{
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		float speed = 0.5f + 0.15f * static_cast<float>(i % 8);
+		float angle = time * speed + GOLDEN_ANGLE * static_cast<float>(i);
+
+		output[i] = lights[i];
+		output[i].positionRadius.x += LIGHT_ORBIT_RADIUS * std::cos(angle);
+		output[i].positionRadius.z += LIGHT_ORBIT_RADIUS * std::sin(angle);
+	}
+}
+
+SceneCamera createLightingCamera(float aspectRatio)
+{
+	glm::vec3 eye(0.0f, 16.0f, -LIGHT_FIELD_HALF_SIZE - 10.0f);
+	glm::vec3 target(0.0f, 0.0f, LIGHT_FIELD_HALF_SIZE * 0.25f);
+
+	SceneCamera camera;
+	camera.view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	camera.projection = glm::perspective(glm::radians(60.0f), aspectRatio, 0.5f, LIGHT_FIELD_HALF_SIZE * 3.0f);
+	camera.projection[1][1] *= -1.0f;
+	camera.viewProjection = camera.projection * camera.view;
+
+	return camera;
+}
+
+std::vector<SceneDraw> generateSceneDraws(uint32_t drawCount, uint32_t pipelineCount, uint32_t materialCount, uint32_t meshCount)
+{
+	std::vector<SceneDraw> draws(drawCount);
+
+	std::mt19937 generator(5678);
+	std::uniform_real_distribution<float> positionDistribution(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> sizeDistribution(0.005f, 0.03f);
+	std::uniform_real_distribution<float> depthDistribution(0.0f, 1.0f);
+	std::uniform_int_distribution<uint32_t> pipelineDistribution(0, pipelineCount - 1);
+	std::uniform_int_distribution<uint32_t> materialDistribution(0, materialCount - 1);
+	std::uniform_int_distribution<uint32_t> meshDistribution(0, meshCount - 1);
+
+	for (SceneDraw& draw : draws)
+	{
+		float size = sizeDistribution(generator);
+
+		draw.rect = glm::vec4(positionDistribution(generator), positionDistribution(generator), size, size);
+		draw.pipeline = pipelineDistribution(generator);
+		draw.material = materialDistribution(generator);
+		draw.mesh = meshDistribution(generator);
+		draw.depth = depthDistribution(generator);
+	}
+
+	return draws;
+}
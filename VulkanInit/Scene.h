@@ -0,0 +1,41 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <vector>
+
+struct SceneInstance
+{
+	glm::vec4 center;
+	glm::vec4 halfExtents;
+	glm::vec4 color;
+};
+
+struct SceneLight
+{
+	glm::vec4 positionRadius;
+	glm::vec4 color;
+};
+
+struct SceneDraw
+{
+	glm::vec4 rect;
+	uint32_t pipeline;
+	uint32_t material;
+	uint32_t mesh;
+	float depth;
+};
+
+struct SceneCamera
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+};
+
+std::vector<SceneInstance> generateCityScene(uint32_t instanceCount);
+SceneCamera createSceneCamera(uint32_t instanceCount, float aspectRatio);
+SceneCamera createParticleCamera(float aspectRatio);
+std::vector<SceneLight> generateSceneLights(uint32_t lightCount);
+void animateSceneLights(const std::vector<SceneLight>& lights, float time, SceneLight* output);
+SceneCamera createLightingCamera(float aspectRatio);
+std::vector<SceneDraw> generateSceneDraws(uint32_t drawCount, uint32_t pipelineCount, uint32_t materialCount, uint32_t meshCount);
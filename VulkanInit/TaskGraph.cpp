@@ -0,0 +1,168 @@
+#include "TaskGraph.h"
+#include <stdexcept>
+
+TaskGraph::TaskGraph()
+	: m_threadPool(nullptr),
+	m_inFlight(0),
+	m_totalMs(0.0)
+{
+}
+
+TaskGraph::TaskId TaskGraph::addTask(const std::string& name, std::function<void()> function,
+	const std::vector<TaskId>& dependencies, bool callingThread)
+{
+	TaskId id = m_tasks.size();
+
+	Task task;
+	task.name = name;
+	task.function = function;
+	task.callingThread = callingThread;
+	task.pendingDependencies = dependencies.size();
+	task.startMs = 0.0;
+	task.durationMs = 0.0;
+
+	for (TaskId dependency : dependencies)
+	{
+		if (dependency >= id)
+		{
+			throw std::runtime_error("Task dependency must be added before its dependent.");
+		}
+
+		m_tasks[dependency].dependents.push_back(id);
+	}
+
+	m_tasks.push_back(task);
+
+	return id;
+}
+
+void TaskGraph::schedule(TaskId id)
+{
+	if (m_threadPool == nullptr || m_tasks[id].callingThread)
+	{
+		m_callingThreadTasks.push(id);
+		m_changed.notify_all();
+	}
+	else
+	{
+		m_threadPool->submit([this, id]()
+		{
+			execute(id);
+		});
+	}
+}
+
+void TaskGraph::execute(TaskId id)
+{
+	Task& task = m_tasks[id];
+	std::exception_ptr error;
+
+	auto start = std::chrono::steady_clock::now();
+
+	try
+	{
+		task.function();
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	task.startMs = std::chrono::duration<double, std::milli>(start - m_start).count();
+	task.durationMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+	complete(id, error);
+}
+
+void TaskGraph::complete(TaskId id, std::exception_ptr error)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (error && !m_error)
+	{
+		m_error = error;
+	}
+
+	if (!m_error)
+	{
+		for (TaskId dependent : m_tasks[id].dependents)
+		{
+			if (--m_tasks[dependent].pendingDependencies == 0)
+			{
+				++m_inFlight;
+				schedule(dependent);
+			}
+		}
+	}
+
+	--m_inFlight;
+	m_changed.notify_all();
+}
+
+void TaskGraph::run(ThreadPool* threadPool)
+{
+	m_threadPool = threadPool;
+	m_start = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (TaskId id = 0; id < m_tasks.size(); ++id)
+	{
+		if (m_tasks[id].pendingDependencies == 0)
+		{
+			++m_inFlight;
+			schedule(id);
+		}
+	}
+
+	while (true)
+	{
+		m_changed.wait(lock, [this]()
+		{
+			return !m_callingThreadTasks.empty() || m_inFlight == 0;
+		});
+
+		if (m_callingThreadTasks.empty())
+		{
+			break;
+		}
+
+		TaskId id = m_callingThreadTasks.front();
+		m_callingThreadTasks.pop();
+
+		if (m_error)
+		{
+			--m_inFlight;
+			continue;
+		}
+
+		lock.unlock();
+		execute(id);
+		lock.lock();
+	}
+
+	m_totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+}
+
+std::vector<TaskTiming> TaskGraph::getTimings() const
+{
+	std::vector<TaskTiming> timings;
+
+	for (const Task& task : m_tasks)
+	{
+		timings.push_back({ task.name, task.startMs, task.durationMs });
+	}
+
+	return timings;
+}
+
+double TaskGraph::getTotalMs() const
+{
+	return m_totalMs;
+}
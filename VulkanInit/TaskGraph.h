@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+struct TaskTiming
+{
+	std::string name;
+	double startMs;
+	double durationMs;
+};
+
+// Runs a set of tasks in dependency order. Tasks whose dependencies have
+// finished are handed to the thread pool; tasks marked callingThread run on
+// the thread that called run(), for work that must stay on the main thread.
+// A dependency must be added before the task that waits for it, so the graph
+// cannot contain cycles. The first exception thrown by a task stops scheduling
+// and is rethrown from run() once the tasks already in flight have finished.
+class TaskGraph
+{
+public:
+	typedef size_t TaskId;
+
+private:
+	struct Task
+	{
+		std::string name;
+		std::function<void()> function;
+		bool callingThread;
+		size_t pendingDependencies;
+		std::vector<TaskId> dependents;
+		double startMs;
+		double durationMs;
+	};
+
+	std::vector<Task> m_tasks;
+	ThreadPool* m_threadPool;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::queue<TaskId> m_callingThreadTasks;
+	size_t m_inFlight;
+	std::exception_ptr m_error;
+	std::chrono::steady_clock::time_point m_start;
+	double m_totalMs;
+
+	void schedule(TaskId id);
+	void execute(TaskId id);
+	void complete(TaskId id, std::exception_ptr error);
+
+public:
+	TaskGraph();
+
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	TaskId addTask(const std::string& name, std::function<void()> function,
+		const std::vector<TaskId>& dependencies = std::vector<TaskId>(), bool callingThread = false);
+	void run(ThreadPool* threadPool);
+
+	std::vector<TaskTiming> getTimings() const;
+	double getTotalMs() const;
+};
@@ -0,0 +1,144 @@
+#include "ThreadPool.h"
+#include <exception>
+
+ThreadPool::ThreadPool(size_t workerCount)
+	: m_activeTasks(0),
+	m_stopping(false)
+{
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_taskAvailable.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(task));
+	}
+
+	m_taskAvailable.notify_one();
+}
+
+// Waits only for its own tasks, unlike waitIdle(), and runs the first one on
+// the calling thread so a worker can call it without starving the pool. The
+// first exception thrown by any task is rethrown once every task has finished.
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	std::mutex doneMutex;
+	std::condition_variable done;
+	size_t remaining = count;
+	std::exception_ptr firstException;
+
+	auto runTask = [&](size_t i)
+	{
+		std::exception_ptr exception;
+
+		try
+		{
+			task(i);
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(doneMutex);
+		if (exception && !firstException)
+		{
+			firstException = exception;
+		}
+
+		if (--remaining == 0)
+		{
+			done.notify_one();
+		}
+	};
+
+	for (size_t i = 1; i < count; ++i)
+	{
+		submit([&runTask, i]()
+		{
+			runTask(i);
+		});
+	}
+
+	runTask(0);
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	done.wait(lock, [&remaining] { return remaining == 0; });
+
+	if (firstException)
+	{
+		std::rethrow_exception(firstException);
+	}
+}
+
+void ThreadPool::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this] { return m_tasks.empty() && m_activeTasks == 0; });
+}
+
+size_t ThreadPool::getWorkerCount() const
+{
+	return m_workers.size();
+}
+
+size_t ThreadPool::defaultWorkerCount()
+{
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAvailable.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+			if (m_tasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+			++m_activeTasks;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_activeTasks;
+		}
+
+		m_idle.notify_all();
+	}
+}
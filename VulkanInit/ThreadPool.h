@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+	std::vector<std::thread> m_workers;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_taskAvailable;
+	std::condition_variable m_idle;
+	size_t m_activeTasks;
+	bool m_stopping;
+
+	void workerLoop();
+
+public:
+	explicit ThreadPool(size_t workerCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> task);
+	void parallelFor(size_t count, const std::function<void(size_t)>& task);
+	void waitIdle();
+	size_t getWorkerCount() const;
+
+	static size_t defaultWorkerCount();
+};
@@ -0,0 +1,118 @@
+#include "TimelineSemaphore.h"
+#include <stdexcept>
+
+TimelineSemaphore::TimelineSemaphore(VkDevice device, const VkAllocationCallbacks* allocator)
+	: m_vkDevice(device),
+	m_vkAllocator(allocator),
+	m_vkSemaphore(VK_NULL_HANDLE),
+	m_lastValue(0),
+	m_completedValue(0)
+{
+	m_waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+		vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+	m_getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+		vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+
+	if (m_waitSemaphores == nullptr || m_getSemaphoreCounterValue == nullptr)
+	{
+		throw std::runtime_error("Failed to load timeline semaphore functions.");
+	}
+
+	VkSemaphoreTypeCreateInfoKHR typeCreateInfo = {};
+	typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+	typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	typeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+	VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, allocator, &m_vkSemaphore);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timeline semaphore.");
+	}
+}
+
+VkSemaphore TimelineSemaphore::getHandle() const
+{
+	return m_vkSemaphore;
+}
+
+uint64_t TimelineSemaphore::getLastValue() const
+{
+	return m_lastValue;
+}
+
+uint64_t TimelineSemaphore::nextValue()
+{
+	return ++m_lastValue;
+}
+
+uint64_t TimelineSemaphore::getCompletedValue()
+{
+	uint64_t value;
+	VkResult result = m_getSemaphoreCounterValue(m_vkDevice, m_vkSemaphore, &value);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to read timeline semaphore value.");
+	}
+
+	m_completedValue = value;
+
+	return m_completedValue;
+}
+
+bool TimelineSemaphore::isComplete(uint64_t value)
+{
+	return value <= m_completedValue || value <= getCompletedValue();
+}
+
+void TimelineSemaphore::wait(uint64_t value)
+{
+	if (value <= m_completedValue)
+	{
+		return;
+	}
+
+	VkSemaphoreWaitInfoKHR waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_vkSemaphore;
+	waitInfo.pValues = &value;
+
+	VkResult result = m_waitSemaphores(m_vkDevice, &waitInfo, UINT64_MAX);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to wait for timeline semaphore.");
+	}
+
+	m_completedValue = value;
+}
+
+void TimelineSemaphore::defer(uint64_t value, std::function<void()> work)
+{
+	m_deferredWork.push_back({ value, work });
+}
+
+void TimelineSemaphore::retire()
+{
+	if (m_deferredWork.empty() || !isComplete(m_deferredWork.front().value))
+	{
+		return;
+	}
+
+	while (!m_deferredWork.empty() && m_deferredWork.front().value <= m_completedValue)
+	{
+		std::function<void()> work = m_deferredWork.front().work;
+		m_deferredWork.pop_front();
+		work();
+	}
+}
+
+void TimelineSemaphore::destroy()
+{
+	m_deferredWork.clear();
+	vkDestroySemaphore(m_vkDevice, m_vkSemaphore, m_vkAllocator);
+	m_vkSemaphore = VK_NULL_HANDLE;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// A VK_KHR_timeline_semaphore with a monotonically increasing value. Each
+// queue submission signals the next value, so the host can wait for any
+// earlier submission without a fence, other queues can wait on a value, and
+// work tied to a submission is retired once the GPU has passed its value.
+class TimelineSemaphore
+{
+private:
+	struct DeferredWork
+	{
+		uint64_t value;
+		std::function<void()> work;
+	};
+
+	VkDevice m_vkDevice;
+	const VkAllocationCallbacks* m_vkAllocator;
+	VkSemaphore m_vkSemaphore;
+	PFN_vkWaitSemaphoresKHR m_waitSemaphores;
+	PFN_vkGetSemaphoreCounterValueKHR m_getSemaphoreCounterValue;
+	uint64_t m_lastValue;
+	uint64_t m_completedValue;
+	std::deque<DeferredWork> m_deferredWork;
+
+public:
+	TimelineSemaphore(VkDevice device, const VkAllocationCallbacks* allocator);
+
+	TimelineSemaphore(const TimelineSemaphore&) = delete;
+	TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+
+	VkSemaphore getHandle() const;
+	uint64_t getLastValue() const;
+	uint64_t nextValue();
+
+	uint64_t getCompletedValue();
+	bool isComplete(uint64_t value);
+	void wait(uint64_t value);
+
+	void defer(uint64_t value, std::function<void()> work);
+	void retire();
+	void destroy();
+};
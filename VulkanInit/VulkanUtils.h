@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vulkan.h>
+#include <vector>
+
+VkDescriptorSetLayoutBinding layoutBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stages);
+VkDescriptorSetLayout createDescriptorSetLayout(VkDevice device, const VkAllocationCallbacks* allocator,
+	const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+VkWriteDescriptorSet bufferWrite(VkDescriptorSet set, uint32_t binding, const VkDescriptorBufferInfo* bufferInfo);
+VkWriteDescriptorSet imageWrite(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+	const VkDescriptorImageInfo* imageInfo);
+void memoryBarrier(VkCommandBuffer commandBuffer,
+	VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
@@ -0,0 +1,324 @@
+#include "Engine.h"
+#include <stdexcept>
+
+void Engine::createViewportTargets()
+{
+	for (size_t i = 1; i < m_windows.size(); ++i)
+	{
+		createWindowTargets(m_windows[i]);
+	}
+}
+
+void Engine::createWindowTargets(EngineWindow& window)
+{
+	createSwapChainImageViews(window.images, window.imageViews);
+	window.framebuffers.resize(window.imageViews.size());
+
+	VkFramebufferCreateInfo framebufferCreateInfo = {};
+	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferCreateInfo.renderPass = m_vkRenderPass;
+	framebufferCreateInfo.attachmentCount = 1;
+	framebufferCreateInfo.width = window.extent.width;
+	framebufferCreateInfo.height = window.extent.height;
+	framebufferCreateInfo.layers = 1;
+
+	for (size_t i = 0; i < window.imageViews.size(); ++i)
+	{
+		framebufferCreateInfo.pAttachments = &window.imageViews[i];
+
+		VkResult result = vkCreateFramebuffer(m_vkDevice, &framebufferCreateInfo, hostAllocator(MemorySubsystem::Swapchain), &window.framebuffers[i]);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create swap chain frame buffer.");
+		}
+	}
+
+	window.commandBuffers.resize(window.framebuffers.size());
+
+	VkCommandBufferAllocateInfo commandBufferInfo = {};
+	commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferInfo.commandPool = m_vkCommandPool;
+	commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferInfo.commandBufferCount = static_cast<uint32_t>(window.commandBuffers.size());
+
+	VkResult result = vkAllocateCommandBuffers(m_vkDevice, &commandBufferInfo, window.commandBuffers.data());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate command buffers.");
+	}
+
+	window.imageTimelineValues.assign(window.images.size(), 0);
+}
+
+void Engine::destroyWindowTargets(EngineWindow& window)
+{
+	for (VkFramebuffer framebuffer : window.framebuffers)
+	{
+		vkDestroyFramebuffer(m_vkDevice, framebuffer, hostAllocator(MemorySubsystem::Swapchain));
+	}
+
+	for (VkImageView imageView : window.imageViews)
+	{
+		vkDestroyImageView(m_vkDevice, imageView, hostAllocator(MemorySubsystem::Swapchain));
+	}
+
+	if (!window.commandBuffers.empty())
+	{
+		vkFreeCommandBuffers(m_vkDevice, m_vkCommandPool, static_cast<uint32_t>(window.commandBuffers.size()), window.commandBuffers.data());
+	}
+
+	window.framebuffers.clear();
+	window.imageViews.clear();
+	window.commandBuffers.clear();
+}
+
+bool Engine::recreateViewportSwapchain(EngineWindow& window)
+{
+	SwapChainSupportDetails supportDetails = querySwapChainSupport(m_vkPhysicalDevice, window.surface);
+	VkExtent2D extent = chooseSwapExtent(supportDetails.capabilities, window.sdlWindow);
+
+	// A minimised window has no area to present to; it stays out of date
+	// until it is restored.
+	if (extent.width == 0 || extent.height == 0)
+	{
+		return false;
+	}
+
+	vkDeviceWaitIdle(m_vkDevice);
+
+	destroyWindowTargets(window);
+	window.extent = extent;
+	createSwapChain(window);
+	createWindowTargets(window);
+
+	window.outOfDate = false;
+	++window.stats.swapchainRecreations;
+	return true;
+}
+
+bool Engine::acquireWindowImage(EngineWindow& window)
+{
+	std::chrono::steady_clock::time_point acquireStart = std::chrono::steady_clock::now();
+
+	VkResult result = vkAcquireNextImageKHR(m_vkDevice, window.swapchain, UINT64_MAX,
+		window.imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &window.imageIndex);
+
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		window.outOfDate = true;
+		return false;
+	}
+
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+	{
+		throw std::runtime_error("Failed to acquire next image.");
+	}
+
+	// A suboptimal image still presents correctly, so it is used for this
+	// frame and the swapchain is replaced before the next acquire.
+	window.outOfDate = result == VK_SUBOPTIMAL_KHR;
+
+	window.stats.acquireTimeMs = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - acquireStart).count();
+	return true;
+}
+
+std::vector<VkCommandBuffer> Engine::recordViewports(VkPipeline pipeline)
+{
+	std::vector<VkCommandBuffer> commandBuffers;
+
+	for (size_t i = 1; i < m_windows.size(); ++i)
+	{
+		EngineWindow& window = m_windows[i];
+
+		// A viewport that skips a frame neither acquires nor presents, so a
+		// slow interval costs the other windows nothing.
+		window.presenting = m_frameNumber % window.stats.presentInterval == 0;
+		if (!window.presenting)
+		{
+			++window.stats.skippedFrames;
+			continue;
+		}
+
+		// Only this viewport sits the frame out when its swapchain no longer
+		// matches its surface; the other windows keep presenting.
+		if ((window.outOfDate && !recreateViewportSwapchain(window)) || !acquireWindowImage(window))
+		{
+			window.presenting = false;
+			++window.stats.skippedFrames;
+			continue;
+		}
+
+		m_graphicsTimeline->wait(window.imageTimelineValues[window.imageIndex]);
+
+		std::chrono::steady_clock::time_point recordStart = std::chrono::steady_clock::now();
+		recordViewportCommands(window, pipeline);
+		window.stats.recordTimeMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - recordStart).count();
+
+		commandBuffers.push_back(window.commandBuffers[window.imageIndex]);
+	}
+
+	return commandBuffers;
+}
+
+void Engine::recordViewportCommands(EngineWindow& window, VkPipeline pipeline)
+{
+	VkCommandBuffer commandBuffer = window.commandBuffers[window.imageIndex];
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin command buffer.");
+	}
+
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = m_vkRenderPass;
+	renderPassInfo.framebuffer = window.framebuffers[window.imageIndex];
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = window.extent;
+
+	VkClearValue clearValue = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValue;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(window.extent.width);
+	viewport.height = static_cast<float>(window.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &renderPassInfo.renderArea);
+
+	if (m_settings.queuedDraws > 0)
+	{
+		recordQueuedDraws(commandBuffer);
+	}
+	else
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+		++m_pendingFrameStats[m_currentFrame].drawCount;
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	result = vkEndCommandBuffer(commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to end command buffer.");
+	}
+}
+
+void Engine::presentWindows()
+{
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkSwapchainKHR> swapChains;
+	std::vector<uint32_t> imageIndices;
+
+	for (EngineWindow& window : m_windows)
+	{
+		if (window.presenting)
+		{
+			waitSemaphores.push_back(window.renderFinishedSemaphores[m_currentFrame]);
+			swapChains.push_back(window.swapchain);
+			imageIndices.push_back(window.imageIndex);
+		}
+	}
+
+	// Every window presenting this frame goes out in a single call, so the
+	// presentation engine sees them together instead of one after another.
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	presentInfo.pWaitSemaphores = waitSemaphores.data();
+	presentInfo.swapchainCount = static_cast<uint32_t>(swapChains.size());
+	presentInfo.pSwapchains = swapChains.data();
+	presentInfo.pImageIndices = imageIndices.data();
+
+	std::vector<VkResult> results(swapChains.size(), VK_SUCCESS);
+	presentInfo.pResults = results.data();
+
+	VkResult result = vkQueuePresentKHR(m_vkPresentationQueue, &presentInfo);
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		throw std::runtime_error("Failed to queue presentation.");
+	}
+
+	std::chrono::steady_clock::time_point presentTime = std::chrono::steady_clock::now();
+	size_t presented = 0;
+
+	for (EngineWindow& window : m_windows)
+	{
+		if (!window.presenting)
+		{
+			continue;
+		}
+
+		// The call reports the worst result over every swapchain, so each
+		// window is judged by its own entry.
+		VkResult windowResult = results[presented++];
+		if (windowResult == VK_SUBOPTIMAL_KHR || windowResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			window.outOfDate = true;
+		}
+		else if (windowResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to queue presentation.");
+		}
+
+		if (windowResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			++window.stats.skippedFrames;
+			continue;
+		}
+
+		if (window.stats.presentedFrames > 0)
+		{
+			window.stats.presentIntervalMs = std::chrono::duration<double, std::milli>(presentTime - window.lastPresent).count();
+		}
+
+		window.lastPresent = presentTime;
+		++window.stats.presentedFrames;
+	}
+}
+
+void Engine::destroyWindows()
+{
+	for (EngineWindow& window : m_windows)
+	{
+		for (VkSemaphore semaphore : window.imageAvailableSemaphores)
+		{
+			vkDestroySemaphore(m_vkDevice, semaphore, hostAllocator(MemorySubsystem::Sync));
+		}
+
+		for (VkSemaphore semaphore : window.renderFinishedSemaphores)
+		{
+			vkDestroySemaphore(m_vkDevice, semaphore, hostAllocator(MemorySubsystem::Sync));
+		}
+
+		for (VkFramebuffer framebuffer : window.framebuffers)
+		{
+			vkDestroyFramebuffer(m_vkDevice, framebuffer, hostAllocator(MemorySubsystem::Swapchain));
+		}
+
+		for (VkImageView imageView : window.imageViews)
+		{
+			vkDestroyImageView(m_vkDevice, imageView, hostAllocator(MemorySubsystem::Swapchain));
+		}
+
+		vkDestroySwapchainKHR(m_vkDevice, window.swapchain, hostAllocator(MemorySubsystem::Swapchain));
+		vkDestroySurfaceKHR(m_vkInstance, window.surface, hostAllocator(MemorySubsystem::Core));
+	}
+}
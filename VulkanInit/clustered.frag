@@ -0,0 +1,70 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+const uint CLUSTER_GRID_X = 16;
+const uint CLUSTER_GRID_Y = 9;
+const uint CLUSTER_GRID_Z = 24;
+const uint CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+const uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+struct Light
+{
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform Lighting
+{
+    mat4 view;
+    mat4 viewProjection;
+    mat4 inverseProjection;
+    vec4 depthSlicing;
+    vec4 screenSize;
+    uint lightCount;
+} lighting;
+
+layout(std430, set = 0, binding = 1) readonly buffer Lights
+{
+    Light lights[];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer Clusters
+{
+    uint lightCounts[CLUSTER_COUNT];
+    uint lightIndices[];
+};
+
+layout(location = 0) in vec3 fragPosition;
+layout(location = 1) in float fragDistance;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 albedo = vec3(0.8);
+const vec3 ambient = vec3(0.02);
+const vec3 normal = vec3(0.0, 1.0, 0.0);
+
+void main() {
+    uvec2 tile = uvec2(gl_FragCoord.xy / lighting.screenSize.xy * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y));
+    float viewDistance = max(fragDistance, lighting.depthSlicing.x);
+    int slice = int(log(viewDistance) * lighting.depthSlicing.z - lighting.depthSlicing.w);
+
+    uvec3 cell = uvec3(
+        min(tile, uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1)),
+        uint(clamp(slice, 0, int(CLUSTER_GRID_Z) - 1)));
+    uint cluster = cell.x + cell.y * CLUSTER_GRID_X + cell.z * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+
+    vec3 color = ambient * albedo;
+    uint count = lightCounts[cluster];
+
+    for (uint i = 0; i < count; ++i)
+    {
+        Light light = lights[lightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+        vec3 offset = light.positionRadius.xyz - fragPosition;
+        float distanceSquared = dot(offset, offset);
+        float falloff = clamp(1.0 - distanceSquared / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+
+        color += albedo * light.color.rgb * falloff * falloff * max(dot(normal, offset * inversesqrt(distanceSquared)), 0.0);
+    }
+
+    outColor = vec4(color, 1.0);
+}
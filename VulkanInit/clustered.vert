@@ -0,0 +1,34 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform Lighting
+{
+    mat4 view;
+    mat4 viewProjection;
+    mat4 inverseProjection;
+    vec4 depthSlicing;
+    vec4 screenSize;
+    uint lightCount;
+} lighting;
+
+layout(location = 0) out vec3 fragPosition;
+layout(location = 1) out float fragDistance;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0),
+    vec2( 1.0, -1.0),
+    vec2( 1.0,  1.0),
+    vec2(-1.0, -1.0),
+    vec2( 1.0,  1.0),
+    vec2(-1.0,  1.0)
+);
+
+const float floorHalfSize = 64.0;
+
+void main() {
+    vec3 position = vec3(corners[gl_VertexIndex].x, 0.0, corners[gl_VertexIndex].y) * floorHalfSize;
+
+    gl_Position = lighting.viewProjection * vec4(position, 1.0);
+    fragPosition = position;
+    fragDistance = -(lighting.view * vec4(position, 1.0)).z;
+}
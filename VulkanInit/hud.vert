@@ -0,0 +1,27 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+struct HudVertex
+{
+    vec2 position;
+    uint uv;
+    uint color;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Vertices
+{
+    HudVertex vertices[];
+};
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+
+// Pulls HUD vertices from the per-frame ring buffer. The vertex index already
+// includes the frame's first vertex, so no vertex input state is needed.
+void main() {
+    HudVertex hudVertex = vertices[gl_VertexIndex];
+
+    gl_Position = vec4(hudVertex.position, 0.0, 1.0);
+    fragUv = unpackUnorm2x16(hudVertex.uv);
+    fragColor = unpackUnorm4x8(hudVertex.color);
+}
@@ -1,31 +1,443 @@
 #include "SDL.h"
 #include "Engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+
+void reportMemoryBudget(const MemoryBudgetEvent& event)
+{
+	std::cout << "Memory heap " << event.heapIndex << " is close to its budget: "
+		<< event.usage / (1024 * 1024) << " of " << event.budget / (1024 * 1024) << " MB used" << std::endl;
+}
+
+void reportStartup(const StartupStats& stats)
+{
+	std::cout << "Init: " << stats.initTimeMs << " ms, first frame: " << stats.timeToFirstFrameMs << " ms" << std::endl;
+
+	for (const TaskTiming& phase : stats.phases)
+	{
+		std::cout << "  " << phase.name << ": " << phase.durationMs << " ms (started at " << phase.startMs << " ms)" << std::endl;
+	}
+}
+
+void reportParticles(const ParticleStats& stats)
+{
+	std::cout << "Particles: " << stats.particleCount
+		<< (stats.asyncCompute ? " (async compute)" : " (graphics queue)")
+		<< ", simulate: " << stats.simulateGpuTimeMs << " ms"
+		<< ", sort: " << stats.sortGpuTimeMs << " ms"
+		<< ", draw: " << stats.drawGpuTimeMs << " ms"
+		<< ", GPU throughput: " << stats.particlesPerSecond / 1000000.0 << " M particles/s" << std::endl;
+}
+
+void reportHud(const FrameStats& stats)
+{
+	std::cout << "HUD overlay: " << stats.hudCpuTimeMs << " ms CPU, " << stats.hudGpuTimeMs << " ms GPU"
+		<< " (frame: " << stats.cpuTimeMs << " ms CPU, " << stats.gpuTimeMs << " ms GPU, "
+		<< stats.drawCount << " draws)" << std::endl;
+}
+
+void reportRenderScale(const FrameStats& stats, float targetFrameTimeMs)
+{
+	std::cout << "Render scale: " << stats.renderScale * 100.0f << "% (GPU frame: " << stats.gpuTimeMs
+		<< " ms, target: " << targetFrameTimeMs << " ms)" << std::endl;
+}
+
+void reportLighting(const LightingStats& stats)
+{
+	std::cout << "Lights: " << stats.lightCount
+		<< ", binning: " << stats.binGpuTimeMs << " ms"
+		<< ", shading: " << stats.shadeGpuTimeMs << " ms"
+		<< ", lights per cluster: " << stats.averageClusterLights
+		<< " (max " << stats.maxClusterLights
+		<< ", " << stats.overflowedClusters << " of " << stats.clusterCount << " clusters full)" << std::endl;
+}
+
+// Every light count gets a fresh engine so each run starts from the same
+// state, and the first frames are left out while clocks and caches settle.
+void runLightingBenchmark(EngineSettings settings, uint32_t frameCount)
+{
+	const uint32_t lightCounts[] = { 100, 250, 500, 1000, 2500, 5000, 10000 };
+	const uint32_t warmupFrames = 10;
+
+	settings.headless = true;
+	settings.clusteredLighting = true;
+
+	for (uint32_t lightCount : lightCounts)
+	{
+		settings.lightCount = lightCount;
+
+		double totalGpuTimeMs = 0.0;
+		uint64_t measuredFrames = 0;
+
+		Engine engine(settings);
+		engine.addFrameStatsCallback([&](const FrameStats& stats)
+		{
+			if (stats.frameNumber >= warmupFrames)
+			{
+				totalGpuTimeMs += stats.gpuTimeMs;
+				++measuredFrames;
+			}
+		});
+
+		engine.init(nullptr);
+
+		double totalBinTimeMs = 0.0;
+		double totalShadeTimeMs = 0.0;
+		uint64_t measuredPasses = 0;
+
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			engine.render();
+
+			if (frame >= warmupFrames)
+			{
+				totalBinTimeMs += engine.getLightingStats().binGpuTimeMs;
+				totalShadeTimeMs += engine.getLightingStats().shadeGpuTimeMs;
+				++measuredPasses;
+			}
+		}
+
+		engine.cleanUp();
+
+		const LightingStats& stats = engine.getLightingStats();
+		measuredFrames = std::max<uint64_t>(measuredFrames, 1);
+		measuredPasses = std::max<uint64_t>(measuredPasses, 1);
+
+		std::cout << "Lights " << lightCount
+			<< ": GPU frame " << totalGpuTimeMs / measuredFrames << " ms"
+			<< ", binning " << totalBinTimeMs / measuredPasses << " ms"
+			<< ", shading " << totalShadeTimeMs / measuredPasses << " ms"
+			<< ", " << stats.averageClusterLights << " lights per cluster (max " << stats.maxClusterLights
+			<< ", " << stats.overflowedClusters << " clusters full)" << std::endl;
+	}
+}
+
+void reportRenderQueue(const RenderQueueStats& stats)
+{
+	std::cout << "Queued draws: " << stats.drawCount
+		<< ", sort: " << stats.sortTimeMs << " ms on " << stats.sortThreads << " thread(s)"
+		<< ", record: " << stats.recordTimeMs << " ms"
+		<< ", binds: " << stats.pipelineBinds << " pipeline, " << stats.materialBinds << " material, "
+		<< stats.meshBinds << " mesh (" << stats.eliminatedBinds << " eliminated)" << std::endl;
+}
+
+// Times the CPU side of the render queue at one draw count, first with the
+// sort spread over the thread pool and then on the render thread alone.
+void runRenderQueueBenchmark(EngineSettings settings, uint32_t frameCount)
+{
+	const uint32_t warmupFrames = 10;
+
+	settings.headless = true;
+	if (settings.queuedDraws == 0)
+	{
+		settings.queuedDraws = 100000;
+	}
+
+	for (bool parallelSort : { true, false })
+	{
+		settings.parallelSort = parallelSort;
+
+		Engine engine(settings);
+		engine.init(nullptr);
+
+		double totalSortTimeMs = 0.0;
+		double totalRecordTimeMs = 0.0;
+		uint64_t measuredFrames = 0;
+
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			engine.render();
+
+			if (frame >= warmupFrames)
+			{
+				totalSortTimeMs += engine.getRenderQueueStats().sortTimeMs;
+				totalRecordTimeMs += engine.getRenderQueueStats().recordTimeMs;
+				++measuredFrames;
+			}
+		}
+
+		engine.cleanUp();
+
+		const RenderQueueStats& stats = engine.getRenderQueueStats();
+		measuredFrames = std::max<uint64_t>(measuredFrames, 1);
+
+		std::cout << (parallelSort ? "Parallel" : "Serial") << " sort of " << settings.queuedDraws
+			<< " draws: sort " << totalSortTimeMs / measuredFrames << " ms on " << stats.sortThreads << " thread(s)"
+			<< ", record " << totalRecordTimeMs / measuredFrames << " ms"
+			<< ", binds issued " << stats.pipelineBinds + stats.materialBinds + stats.meshBinds
+			<< ", eliminated " << stats.eliminatedBinds << std::endl;
+	}
+}
+
+void reportWindows(const std::vector<WindowStats>& windows)
+{
+	for (size_t i = 0; i < windows.size(); ++i)
+	{
+		const WindowStats& stats = windows[i];
+		std::cout << "Window " << i << ": every " << stats.presentInterval << " frame(s)"
+			<< ", presented " << stats.presentedFrames << ", skipped " << stats.skippedFrames
+			<< ", acquire " << stats.acquireTimeMs << " ms"
+			<< ", record " << stats.recordTimeMs << " ms"
+			<< ", present interval " << stats.presentIntervalMs << " ms"
+			<< ", swapchain recreations " << stats.swapchainRecreations << std::endl;
+	}
+}
 
 int main(int argc, char* args[]) {
 
+	EngineSettings settings;
+	uint32_t frameCount = 300;
+	std::string memoryStatsFile;
+	bool lightingBenchmark = false;
+	bool renderQueueBenchmark = false;
+	uint32_t windowCount = 1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(args[i], "--occlusion") == 0)
+		{
+			settings.occlusionCulling = true;
+		}
+		else if (strcmp(args[i], "--fog") == 0)
+		{
+			settings.sceneFog = true;
+		}
+		else if (strcmp(args[i], "--headless") == 0)
+		{
+			settings.headless = true;
+		}
+		else if (strcmp(args[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frameCount = static_cast<uint32_t>(strtoul(args[++i], nullptr, 10));
+		}
+		else if (strcmp(args[i], "--capture") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(args[i], "png") == 0)
+			{
+				settings.captureFormat = CaptureFormat::Png;
+			}
+			else if (strcmp(args[i], "y4m") == 0)
+			{
+				settings.captureFormat = CaptureFormat::Y4m;
+			}
+			else
+			{
+				std::cerr << "Unknown capture format: " << args[i] << std::endl;
+				exit(-1);
+			}
+		}
+		else if (strcmp(args[i], "--capture-path") == 0 && i + 1 < argc)
+		{
+			settings.capturePath = args[++i];
+		}
+		else if (strcmp(args[i], "--memory-stats") == 0 && i + 1 < argc)
+		{
+			memoryStatsFile = args[++i];
+		}
+		else if (strcmp(args[i], "--serial-init") == 0)
+		{
+			settings.parallelInit = false;
+		}
+		else if (strcmp(args[i], "--particles") == 0)
+		{
+			settings.particles = true;
+		}
+		else if (strcmp(args[i], "--particle-count") == 0 && i + 1 < argc)
+		{
+			settings.particleCount = static_cast<uint32_t>(strtoul(args[++i], nullptr, 10));
+		}
+		else if (strcmp(args[i], "--no-async-compute") == 0)
+		{
+			settings.asyncCompute = false;
+		}
+		else if (strcmp(args[i], "--hud") == 0)
+		{
+			settings.hud = true;
+		}
+		else if (strcmp(args[i], "--record-commands") == 0 && i + 1 < argc)
+		{
+			settings.commandStreamPath = args[++i];
+		}
+		else if (strcmp(args[i], "--dynamic-resolution") == 0)
+		{
+			settings.dynamicResolution = true;
+		}
+		else if (strcmp(args[i], "--target-frame-time") == 0 && i + 1 < argc)
+		{
+			settings.targetFrameTimeMs = static_cast<float>(atof(args[++i]));
+		}
+		else if (strcmp(args[i], "--min-render-scale") == 0 && i + 1 < argc)
+		{
+			settings.minRenderScale = static_cast<float>(atof(args[++i]));
+		}
+		else if (strcmp(args[i], "--clustered-lights") == 0)
+		{
+			settings.clusteredLighting = true;
+		}
+		else if (strcmp(args[i], "--light-count") == 0 && i + 1 < argc)
+		{
+			settings.lightCount = static_cast<uint32_t>(strtoul(args[++i], nullptr, 10));
+		}
+		else if (strcmp(args[i], "--queued-draws") == 0 && i + 1 < argc)
+		{
+			settings.queuedDraws = static_cast<uint32_t>(strtoul(args[++i], nullptr, 10));
+		}
+		else if (strcmp(args[i], "--serial-sort") == 0)
+		{
+			settings.parallelSort = false;
+		}
+		else if (strcmp(args[i], "--windows") == 0 && i + 1 < argc)
+		{
+			windowCount = std::max<uint32_t>(static_cast<uint32_t>(strtoul(args[++i], nullptr, 10)), 1);
+		}
+		else if (strcmp(args[i], "--viewport-interval") == 0 && i + 1 < argc)
+		{
+			settings.viewportPresentInterval = static_cast<uint32_t>(strtoul(args[++i], nullptr, 10));
+		}
+		else if (strcmp(args[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(args[i], "particles") == 0)
+			{
+				settings.headless = true;
+				settings.particles = true;
+			}
+			else if (strcmp(args[i], "lights") == 0)
+			{
+				lightingBenchmark = true;
+			}
+			else if (strcmp(args[i], "render-queue") == 0)
+			{
+				renderQueueBenchmark = true;
+			}
+			else
+			{
+				std::cerr << "Unknown benchmark: " << args[i] << std::endl;
+				exit(-1);
+			}
+		}
+	}
+
+	if (lightingBenchmark)
+	{
+		runLightingBenchmark(settings, frameCount);
+		return 0;
+	}
+
+	if (renderQueueBenchmark)
+	{
+		runRenderQueueBenchmark(settings, frameCount);
+		return 0;
+	}
+
+	if (settings.headless)
+	{
+		Engine engine(settings);
+		engine.addMemoryBudgetCallback(reportMemoryBudget);
+		engine.init(nullptr);
+
+		auto renderStart = std::chrono::steady_clock::now();
+
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			engine.update();
+			engine.render();
+
+			if (frame == 0)
+			{
+				reportStartup(engine.getStartupStats());
+			}
+		}
+
+		double renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+
+		if (settings.particles)
+		{
+			reportParticles(engine.getParticleStats());
+			std::cout << "Wall-clock throughput: "
+				<< static_cast<double>(settings.particleCount) * frameCount / renderSeconds / 1000000.0
+				<< " M particles/s over " << frameCount << " frames" << std::endl;
+		}
+
+		if (settings.clusteredLighting)
+		{
+			reportLighting(engine.getLightingStats());
+		}
+
+		if (settings.queuedDraws > 0)
+		{
+			reportRenderQueue(engine.getRenderQueueStats());
+		}
+
+		if (settings.hud)
+		{
+			reportHud(engine.getFrameStats());
+		}
+
+		if (settings.dynamicResolution)
+		{
+			reportRenderScale(engine.getFrameStats(), settings.targetFrameTimeMs);
+		}
+
+		if (!memoryStatsFile.empty())
+		{
+			engine.dumpMemoryStats(memoryStatsFile);
+		}
+
+		engine.cleanUp();
+
+		FrameCaptureStats captureStats = engine.getFrameCaptureStats();
+		std::cout << "Frames rendered: " << frameCount
+			<< ", captured: " << captureStats.captured
+			<< ", dropped: " << captureStats.dropped
+			<< ", written: " << captureStats.written
+			<< ", failed: " << captureStats.failed << std::endl;
+
+		return 0;
+	}
+
 	SDL_Init(SDL_INIT_VIDEO);
 
-	SDL_Window* window = SDL_CreateWindow(
-		"Vulkan Initialization",
-		SDL_WINDOWPOS_UNDEFINED,	// x
-		SDL_WINDOWPOS_UNDEFINED,	// y
-		800,	// width
-		600,	// height
-		SDL_WINDOW_VULKAN
-	);
+	std::vector<SDL_Window*> windows;
 
-	if (!window)
+	for (uint32_t i = 0; i < windowCount; ++i)
 	{
-		std::cerr << "Cannot create SDL window!" << std::endl;
-		exit(-1);
+		std::string title = i == 0 ? "Vulkan Initialization" : "Viewport " + std::to_string(i);
+
+		SDL_Window* window = SDL_CreateWindow(
+			title.c_str(),
+			SDL_WINDOWPOS_UNDEFINED,	// x
+			SDL_WINDOWPOS_UNDEFINED,	// y
+			settings.width,	// width
+			settings.height,	// height
+			SDL_WINDOW_VULKAN
+		);
+
+		if (!window)
+		{
+			std::cerr << "Cannot create SDL window!" << std::endl;
+			exit(-1);
+		}
+
+		windows.push_back(window);
 	}
 
-	Engine engine;
-	engine.init(window);
+	Engine engine(settings);
+	engine.addMemoryBudgetCallback(reportMemoryBudget);
+	engine.init(windows);
 
 	SDL_Event sdlEvent;
 	bool running = true;
+	Uint32 lastReportTicks = SDL_GetTicks();
+	Uint32 lastWindowReportTicks = SDL_GetTicks();
+	bool sceneFog = settings.sceneFog;
+	bool startupReported = false;
+	uint32_t compiledVariants = engine.getPipelineVariantStats().compiled;
 
 	while (running)
 	{
@@ -40,14 +452,100 @@ int main(int argc, char* args[]) {
 					break;
 				}
 			}
+			else if (sdlEvent.type == SDL_KEYDOWN && sdlEvent.key.keysym.sym == SDLK_f)
+			{
+				sceneFog = !sceneFog;
+				engine.setSceneFog(sceneFog);
+			}
+			else if (sdlEvent.type == SDL_KEYDOWN && sdlEvent.key.keysym.sym == SDLK_h)
+			{
+				engine.setHudVisible(!engine.isHudVisible());
+			}
 		}
 
 		engine.update();
 		engine.render();
+
+		if (!startupReported)
+		{
+			reportStartup(engine.getStartupStats());
+			startupReported = true;
+		}
+
+		if (settings.occlusionCulling && SDL_GetTicks() - lastReportTicks >= 1000)
+		{
+			const OcclusionStats& stats = engine.getOcclusionStats();
+			std::cout << "Instances: " << stats.instanceCount
+				<< ", drawn early: " << stats.drawnEarly
+				<< ", drawn late: " << stats.drawnLate
+				<< ", occluded: " << stats.occluded
+				<< ", frustum culled: " << stats.frustumCulled
+				<< ", culling: " << stats.cullingGpuTimeMs << " ms"
+				<< ", draw: " << stats.drawGpuTimeMs << " ms"
+				<< ", saved: " << stats.savedGpuTimeMs << " ms" << std::endl;
+
+			lastReportTicks = SDL_GetTicks();
+		}
+
+		if (settings.particles && SDL_GetTicks() - lastReportTicks >= 1000)
+		{
+			reportParticles(engine.getParticleStats());
+			lastReportTicks = SDL_GetTicks();
+		}
+
+		if (settings.clusteredLighting && SDL_GetTicks() - lastReportTicks >= 1000)
+		{
+			reportLighting(engine.getLightingStats());
+			lastReportTicks = SDL_GetTicks();
+		}
+
+		if (settings.queuedDraws > 0 && SDL_GetTicks() - lastReportTicks >= 1000)
+		{
+			reportRenderQueue(engine.getRenderQueueStats());
+			lastReportTicks = SDL_GetTicks();
+		}
+
+		if (windows.size() > 1 && SDL_GetTicks() - lastWindowReportTicks >= 1000)
+		{
+			reportWindows(engine.getWindowStats());
+			lastWindowReportTicks = SDL_GetTicks();
+		}
+
+		PipelineVariantStats pipelineStats = engine.getPipelineVariantStats();
+		if (pipelineStats.compiled != compiledVariants)
+		{
+			std::cout << "Pipeline variants compiled: " << pipelineStats.compiled
+				<< ", requests: " << pipelineStats.requests
+				<< ", misses: " << pipelineStats.misses
+				<< ", pending: " << pipelineStats.pending
+				<< ", failed: " << pipelineStats.failed
+				<< ", average compile: " << pipelineStats.totalCompileTimeMs / pipelineStats.compiled << " ms"
+				<< ", max compile: " << pipelineStats.maxCompileTimeMs << " ms" << std::endl;
+
+			compiledVariants = pipelineStats.compiled;
+		}
+	}
+
+	if (!memoryStatsFile.empty())
+	{
+		engine.dumpMemoryStats(memoryStatsFile);
 	}
 
 	engine.cleanUp();
-	SDL_DestroyWindow(window);
+
+	for (SDL_Window* window : windows)
+	{
+		SDL_DestroyWindow(window);
+	}
+
+	if (settings.captureFormat != CaptureFormat::None)
+	{
+		FrameCaptureStats captureStats = engine.getFrameCaptureStats();
+		std::cout << "Frames captured: " << captureStats.captured
+			<< ", dropped: " << captureStats.dropped
+			<< ", written: " << captureStats.written
+			<< ", failed: " << captureStats.failed << std::endl;
+	}
 
 	SDL_Quit();
 	return 0;
@@ -0,0 +1,50 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+struct Particle
+{
+    vec4 position;
+    vec4 velocity;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles
+{
+    Particle particles[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer DrawOrder
+{
+    uint drawOrder[];
+};
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+    vec4 quadSize;
+} pushConstants;
+
+layout(location = 0) out vec2 fragCorner;
+layout(location = 1) out vec4 fragColor;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0),
+    vec2( 1.0, -1.0),
+    vec2( 1.0,  1.0),
+    vec2(-1.0, -1.0),
+    vec2( 1.0,  1.0),
+    vec2(-1.0,  1.0)
+);
+
+void main() {
+    Particle particle = particles[drawOrder[gl_InstanceIndex]];
+    vec2 corner = corners[gl_VertexIndex];
+
+    gl_Position = pushConstants.viewProjection * vec4(particle.position.xyz, 1.0);
+    gl_Position.xy += corner * pushConstants.quadSize.xy;
+
+    float speed = length(particle.velocity.xyz);
+    float fade = clamp(particle.position.w, 0.0, 1.0);
+
+    fragCorner = corner;
+    fragColor = vec4(mix(vec3(1.0, 0.35, 0.1), vec3(0.3, 0.7, 1.0), clamp(speed / 12.0, 0.0, 1.0)), 0.35 * fade);
+}
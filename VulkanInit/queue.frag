@@ -0,0 +1,32 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(constant_id = 0) const uint PATTERN = 0;
+
+layout(set = 0, binding = 0) uniform Material
+{
+    vec4 color;
+} material;
+
+layout(location = 0) in vec2 fragLocal;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float shade = 1.0;
+
+    if (PATTERN == 1)
+    {
+        shade = 1.0 - 0.6 * length(fragLocal);
+    }
+    else if (PATTERN == 2)
+    {
+        shade = fract((fragLocal.x + fragLocal.y) * 3.0) < 0.5 ? 1.0 : 0.5;
+    }
+    else if (PATTERN == 3)
+    {
+        shade = 0.5 + 0.5 * fragLocal.y;
+    }
+
+    outColor = vec4(material.color.rgb * shade, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform Draw
+{
+    vec4 rect;
+} draw;
+
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 0) out vec2 fragLocal;
+
+void main() {
+    gl_Position = vec4(draw.rect.xy + inPosition * draw.rect.zw, 0.0, 1.0);
+    fragLocal = inPosition;
+}
@@ -0,0 +1,24 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(constant_id = 0) const bool FOG_ENABLED = false;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in float fragDistance;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 fogColor = vec3(0.55, 0.6, 0.7);
+const float fogDensity = 0.015;
+
+void main() {
+    vec3 color = fragColor;
+
+    if (FOG_ENABLED)
+    {
+        float visibility = exp(-fogDensity * fragDistance);
+        color = mix(fogColor, color, clamp(visibility, 0.0, 1.0));
+    }
+
+    outColor = vec4(color, 1.0);
+}
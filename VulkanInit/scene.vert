@@ -0,0 +1,53 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+struct Instance
+{
+    vec4 center;
+    vec4 halfExtents;
+    vec4 color;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+} pushConstants;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out float fragDistance;
+
+const vec3 corners[8] = vec3[](
+    vec3(-1.0, -1.0, -1.0),
+    vec3( 1.0, -1.0, -1.0),
+    vec3( 1.0,  1.0, -1.0),
+    vec3(-1.0,  1.0, -1.0),
+    vec3(-1.0, -1.0,  1.0),
+    vec3( 1.0, -1.0,  1.0),
+    vec3( 1.0,  1.0,  1.0),
+    vec3(-1.0,  1.0,  1.0)
+);
+
+const int indices[36] = int[](
+    0, 2, 1, 0, 3, 2,
+    4, 5, 6, 4, 6, 7,
+    0, 1, 5, 0, 5, 4,
+    3, 6, 2, 3, 7, 6,
+    0, 4, 7, 0, 7, 3,
+    1, 2, 6, 1, 6, 5
+);
+
+const float shades[6] = float[](0.8, 0.8, 0.5, 1.0, 0.65, 0.65);
+
+void main() {
+    Instance instance = instances[gl_InstanceIndex];
+    vec3 position = instance.center.xyz + corners[indices[gl_VertexIndex]] * instance.halfExtents.xyz;
+
+    gl_Position = pushConstants.viewProjection * vec4(position, 1.0);
+    fragColor = instance.color.rgb * shades[gl_VertexIndex / 6];
+    fragDistance = gl_Position.w;
+}
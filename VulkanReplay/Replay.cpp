@@ -0,0 +1,207 @@
+#include "Engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+struct ResourceSummary
+{
+	uint64_t count;
+	uint64_t bufferBytes;
+};
+
+EngineSettings settingsFromCapture(const CommandStreamHeader& header)
+{
+	EngineSettings settings;
+	settings.headless = true;
+	settings.width = header.width;
+	settings.height = header.height;
+	settings.occlusionCulling = header.occlusionCulling;
+	settings.sceneInstanceCount = header.sceneInstanceCount;
+	settings.sceneFog = header.sceneFog;
+	settings.particles = header.particles;
+	settings.particleCount = header.particleCount;
+	settings.asyncCompute = header.asyncCompute;
+	settings.hud = header.hud;
+	settings.dynamicResolution = header.dynamicResolution;
+	settings.clusteredLighting = header.clusteredLighting;
+	settings.lightCount = header.lightCount;
+	settings.queuedDraws = header.queuedDraws;
+
+	return settings;
+}
+
+// Swap chain images only exist as engine resources in headless runs, and
+// frame capture buffers depend on the recording options, so neither says
+// anything about whether the replayed scene matches the captured one.
+ResourceSummary summarizeResources(const std::vector<CommandStreamResource>& resources)
+{
+	ResourceSummary summary = {};
+
+	for (const CommandStreamResource& resource : resources)
+	{
+		if (resource.subsystem == static_cast<uint32_t>(MemorySubsystem::Swapchain) ||
+			resource.subsystem == static_cast<uint32_t>(MemorySubsystem::Capture))
+		{
+			continue;
+		}
+
+		++summary.count;
+		summary.bufferBytes += resource.size;
+	}
+
+	return summary;
+}
+
+void reportResources(const std::vector<CommandStreamResource>& captured, const std::vector<CommandStreamResource>& replayed)
+{
+	ResourceSummary capturedSummary = summarizeResources(captured);
+	ResourceSummary replayedSummary = summarizeResources(replayed);
+
+	std::cout << "Resources: " << replayedSummary.count << " created, "
+		<< replayedSummary.bufferBytes / (1024 * 1024) << " MB of buffers" << std::endl;
+
+	if (capturedSummary.count != replayedSummary.count || capturedSummary.bufferBytes != replayedSummary.bufferBytes)
+	{
+		std::cout << "Warning: the capture created " << capturedSummary.count << " resources with "
+			<< capturedSummary.bufferBytes / (1024 * 1024) << " MB of buffers; timings may not be comparable" << std::endl;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	std::string fileName;
+	uint64_t firstFrame = 0;
+	uint64_t lastFrame = std::numeric_limits<uint64_t>::max();
+	uint32_t repeatCount = 1;
+	bool parallelInit = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(args[i], "--first") == 0 && i + 1 < argc)
+		{
+			firstFrame = strtoull(args[++i], nullptr, 10);
+		}
+		else if (strcmp(args[i], "--last") == 0 && i + 1 < argc)
+		{
+			lastFrame = strtoull(args[++i], nullptr, 10);
+		}
+		else if (strcmp(args[i], "--repeat") == 0 && i + 1 < argc)
+		{
+			repeatCount = std::max(1u, static_cast<uint32_t>(strtoul(args[++i], nullptr, 10)));
+		}
+		else if (strcmp(args[i], "--serial-init") == 0)
+		{
+			parallelInit = false;
+		}
+		else
+		{
+			fileName = args[i];
+		}
+	}
+
+	if (fileName.empty())
+	{
+		std::cerr << "Usage: VulkanReplay [--first N] [--last N] [--repeat N] [--serial-init] FILE" << std::endl;
+		exit(-1);
+	}
+
+	CommandStreamReader reader(fileName);
+	const std::vector<CommandStreamFrame>& frames = reader.getFrames();
+
+	if (frames.empty())
+	{
+		std::cerr << "The command stream has no frames." << std::endl;
+		exit(-1);
+	}
+
+	lastFrame = std::min<uint64_t>(lastFrame, frames.size() - 1);
+	if (firstFrame > lastFrame)
+	{
+		std::cerr << "The first reported frame is past the end of the capture." << std::endl;
+		exit(-1);
+	}
+
+	EngineSettings settings = settingsFromCapture(reader.getHeader());
+	settings.parallelInit = parallelInit;
+
+	// Frames always replay from the start because later frames depend on the
+	// state earlier ones leave behind; --first only narrows the report. Each
+	// frame keeps its fastest run, which filters out noise from other work on
+	// the machine.
+	std::vector<FrameStats> fastest(lastFrame + 1);
+	for (FrameStats& stats : fastest)
+	{
+		stats.gpuTimeMs = std::numeric_limits<double>::max();
+	}
+
+	double replaySeconds = std::numeric_limits<double>::max();
+
+	for (uint32_t run = 0; run < repeatCount; ++run)
+	{
+		Engine engine(settings);
+		engine.setReplaySource(&reader);
+		engine.addFrameStatsCallback([&fastest](const FrameStats& stats)
+		{
+			if (stats.frameNumber < fastest.size() && stats.gpuTimeMs < fastest[stats.frameNumber].gpuTimeMs)
+			{
+				fastest[stats.frameNumber] = stats;
+			}
+		});
+
+		engine.init(nullptr);
+
+		if (run == 0)
+		{
+			reportResources(reader.getResources(), engine.getCreatedResources());
+		}
+
+		auto replayStart = std::chrono::steady_clock::now();
+
+		for (uint64_t frame = 0; frame <= lastFrame; ++frame)
+		{
+			engine.replayFrame(frames[frame]);
+		}
+
+		engine.cleanUp();
+
+		replaySeconds = std::min(replaySeconds,
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count());
+	}
+
+	double totalGpuTimeMs = 0.0;
+	uint64_t slowestFrame = firstFrame;
+
+	for (uint64_t frame = firstFrame; frame <= lastFrame; ++frame)
+	{
+		const FrameStats& stats = fastest[frame];
+
+		std::cout << "Frame " << frame << ": GPU " << stats.gpuTimeMs << " ms, CPU " << stats.cpuTimeMs << " ms, "
+			<< stats.drawCount << " draws" << std::endl;
+
+		totalGpuTimeMs += stats.gpuTimeMs;
+		if (stats.gpuTimeMs > fastest[slowestFrame].gpuTimeMs)
+		{
+			slowestFrame = frame;
+		}
+	}
+
+	uint64_t reportedFrames = lastFrame - firstFrame + 1;
+	auto fastestFrame = std::min_element(fastest.begin() + firstFrame, fastest.end(),
+		[](const FrameStats& a, const FrameStats& b)
+		{
+			return a.gpuTimeMs < b.gpuTimeMs;
+		});
+
+	std::cout << "GPU frame time over " << reportedFrames << " frames: min " << fastestFrame->gpuTimeMs
+		<< " ms, average " << totalGpuTimeMs / reportedFrames
+		<< " ms, max " << fastest[slowestFrame].gpuTimeMs << " ms (frame " << slowestFrame << ")" << std::endl;
+	std::cout << "Replayed " << lastFrame + 1 << " frames in " << replaySeconds << " s ("
+		<< (lastFrame + 1) / replaySeconds << " frames/s, best of " << repeatCount << ")" << std::endl;
+
+	return 0;
+}